@@ -176,6 +176,37 @@ check_cxx_source_compiles("
   }
 " HAVE_ISO_STRDUP)
 
+# Determine whether your system supports memory-mapped files.
+
+check_cxx_source_compiles("
+  #include <sys/mman.h>
+  int main() {
+    void *p = mmap(0, 1, PROT_READ, MAP_SHARED, 0, 0);
+    munmap(p, 1);
+    return 0;
+  }
+" HAVE_MMAP)
+
+# Determine whether your system supports copying data between files in the kernel.
+
+check_cxx_source_compiles("
+  #include <unistd.h>
+  int main() {
+    copy_file_range(0, 0, 0, 0, 0, 0);
+    return 0;
+  }
+" HAVE_COPY_FILE_RANGE)
+
+# Determine whether your compiler supports SSE2 intrinsics.
+
+check_cxx_source_compiles("
+  #include <emmintrin.h>
+  int main() {
+    const __m128i x = _mm_setzero_si128();
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, x)) == 0;
+  }
+" HAVE_SSE2)
+
 # Detect WinRT mode
 if(CMAKE_SYSTEM_NAME STREQUAL "WindowsStore")
 	set(PLATFORM WINRT 1)
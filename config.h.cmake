@@ -23,6 +23,15 @@
 /* Defined if your compiler supports ISO _strdup */
 #cmakedefine   HAVE_ISO_STRDUP 1
 
+/* Defined if your system supports memory-mapped files */
+#cmakedefine   HAVE_MMAP 1
+
+/* Defined if your system supports copy_file_range() */
+#cmakedefine   HAVE_COPY_FILE_RANGE 1
+
+/* Defined if your compiler supports SSE2 intrinsics */
+#cmakedefine   HAVE_SSE2 1
+
 /* Defined if zlib is installed */
 #cmakedefine   HAVE_ZLIB 1
 
@@ -86,9 +86,11 @@ namespace
 
   // Detect the file type based on the file extension.
 
-  File* detectByExtension(IOStream *stream, bool readAudioProperties,
+  File* detectByExtension(IOStream *stream, File::ReadParts parts,
                           AudioProperties::ReadStyle audioPropertiesStyle)
   {
+    const bool readAudioProperties = (parts & File::ReadProperties) != 0;
+
 #ifdef _WIN32
     const String s = stream->name().toString();
 #else
@@ -112,11 +114,11 @@ namespace
     File *file = 0;
 
     if(ext == "MP3")
-      file = new MPEG::File(stream, ID3v2::FrameFactory::instance(), readAudioProperties, audioPropertiesStyle);
+      file = new MPEG::File(stream, ID3v2::FrameFactory::instance(), parts, audioPropertiesStyle);
     else if(ext == "OGG")
       file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(ext == "FLAC")
-      file = new FLAC::File(stream, ID3v2::FrameFactory::instance(), readAudioProperties, audioPropertiesStyle);
+      file = new FLAC::File(stream, ID3v2::FrameFactory::instance(), parts, audioPropertiesStyle);
     else if(ext == "MPC")
       file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(ext == "WV")
@@ -128,7 +130,7 @@ namespace
     else if(ext == "TTA")
       file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(ext == "M4A" || ext == "M4R" || ext == "M4B" || ext == "M4P" || ext == "MP4" || ext == "3G2" || ext == "M4V")
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+      file = new MP4::File(stream, parts, audioPropertiesStyle);
     else if(ext == "WMA" || ext == "ASF")
       file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(ext == "AIF" || ext == "AIFF" || ext == "AFC" || ext == "AIFC")
@@ -160,19 +162,21 @@ namespace
 
   // Detect the file type based on the actual content of the stream.
 
-  File *detectByContent(IOStream *stream, bool readAudioProperties,
+  File *detectByContent(IOStream *stream, File::ReadParts parts,
                         AudioProperties::ReadStyle audioPropertiesStyle)
   {
+    const bool readAudioProperties = (parts & File::ReadProperties) != 0;
+
     File *file = 0;
 
     if(MPEG::File::isSupported(stream))
-      file = new MPEG::File(stream, ID3v2::FrameFactory::instance(), readAudioProperties, audioPropertiesStyle);
+      file = new MPEG::File(stream, ID3v2::FrameFactory::instance(), parts, audioPropertiesStyle);
     else if(Ogg::Vorbis::File::isSupported(stream))
       file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(Ogg::FLAC::File::isSupported(stream))
       file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(FLAC::File::isSupported(stream))
-      file = new FLAC::File(stream, ID3v2::FrameFactory::instance(), readAudioProperties, audioPropertiesStyle);
+      file = new FLAC::File(stream, ID3v2::FrameFactory::instance(), parts, audioPropertiesStyle);
     else if(MPC::File::isSupported(stream))
       file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(WavPack::File::isSupported(stream))
@@ -184,7 +188,7 @@ namespace
     else if(TrueAudio::File::isSupported(stream))
       file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(MP4::File::isSupported(stream))
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+      file = new MP4::File(stream, parts, audioPropertiesStyle);
     else if(ASF::File::isSupported(stream))
       file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
     else if(RIFF::AIFF::File::isSupported(stream))
@@ -307,13 +311,29 @@ FileRef::FileRef(FileName fileName, bool readAudioProperties,
                  AudioProperties::ReadStyle audioPropertiesStyle) :
   d(new FileRefPrivate())
 {
-  parse(fileName, readAudioProperties, audioPropertiesStyle);
+  parse(fileName, readAudioProperties ? File::ReadAll : File::ReadTags | File::ReadPictures,
+        audioPropertiesStyle);
 }
 
 FileRef::FileRef(IOStream* stream, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle) :
   d(new FileRefPrivate())
 {
-  parse(stream, readAudioProperties, audioPropertiesStyle);
+  parse(stream, readAudioProperties ? File::ReadAll : File::ReadTags | File::ReadPictures,
+        audioPropertiesStyle);
+}
+
+FileRef::FileRef(FileName fileName, File::ReadParts parts,
+                 AudioProperties::ReadStyle audioPropertiesStyle) :
+  d(new FileRefPrivate())
+{
+  parse(fileName, parts, audioPropertiesStyle);
+}
+
+FileRef::FileRef(IOStream* stream, File::ReadParts parts,
+                 AudioProperties::ReadStyle audioPropertiesStyle) :
+  d(new FileRefPrivate())
+{
+  parse(stream, parts, audioPropertiesStyle);
 }
 
 FileRef::FileRef(File *file) :
@@ -366,6 +386,15 @@ bool FileRef::save()
   return d->file->save();
 }
 
+bool FileRef::saveAtomically()
+{
+  if(isNull()) {
+    debug("FileRef::saveAtomically() - Called without a valid file.");
+    return false;
+  }
+  return d->file->saveAtomically();
+}
+
 const FileRef::FileTypeResolver *FileRef::addFileTypeResolver(const FileRef::FileTypeResolver *resolver) // static
 {
   fileTypeResolvers.prepend(resolver);
@@ -449,25 +478,25 @@ File *FileRef::create(FileName fileName, bool readAudioProperties,
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void FileRef::parse(FileName fileName, bool readAudioProperties,
+void FileRef::parse(FileName fileName, File::ReadParts parts,
                     AudioProperties::ReadStyle audioPropertiesStyle)
 {
   // Try user-defined resolvers.
 
-  d->file = detectByResolvers(fileName, readAudioProperties, audioPropertiesStyle);
+  d->file = detectByResolvers(fileName, (parts & File::ReadProperties) != 0, audioPropertiesStyle);
   if(d->file)
     return;
 
   // Try to resolve file types based on the file extension.
 
   d->stream = new FileStream(fileName);
-  d->file = detectByExtension(d->stream, readAudioProperties, audioPropertiesStyle);
+  d->file = detectByExtension(d->stream, parts, audioPropertiesStyle);
   if(d->file)
     return;
 
   // At last, try to resolve file types based on the actual content.
 
-  d->file = detectByContent(d->stream, readAudioProperties, audioPropertiesStyle);
+  d->file = detectByContent(d->stream, parts, audioPropertiesStyle);
   if(d->file)
     return;
 
@@ -477,22 +506,22 @@ void FileRef::parse(FileName fileName, bool readAudioProperties,
   d->stream = 0;
 }
 
-void FileRef::parse(IOStream *stream, bool readAudioProperties,
+void FileRef::parse(IOStream *stream, File::ReadParts parts,
                     AudioProperties::ReadStyle audioPropertiesStyle)
 {
   // Try user-defined resolvers.
 
-  d->file = detectByResolvers(stream->name(), readAudioProperties, audioPropertiesStyle);
+  d->file = detectByResolvers(stream->name(), (parts & File::ReadProperties) != 0, audioPropertiesStyle);
   if(d->file)
     return;
 
   // Try to resolve file types based on the file extension.
 
-  d->file = detectByExtension(stream, readAudioProperties, audioPropertiesStyle);
+  d->file = detectByExtension(stream, parts, audioPropertiesStyle);
   if(d->file)
     return;
 
   // At last, try to resolve file types based on the actual content of the file.
 
-  d->file = detectByContent(stream, readAudioProperties, audioPropertiesStyle);
+  d->file = detectByContent(stream, parts, audioPropertiesStyle);
 }
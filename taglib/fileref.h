@@ -144,6 +144,30 @@ namespace TagLib {
                      AudioProperties::ReadStyle
                      audioPropertiesStyle = AudioProperties::Average);
 
+    /*!
+     * Create a FileRef from \a fileName and read only the given \a parts of
+     * the file.  MPEG, FLAC and MP4 files skip the tags and pictures which
+     * are not asked for; the other formats only honor ReadProperties.
+     *
+     * \see File::ReadParts
+     */
+    FileRef(FileName fileName, File::ReadParts parts,
+            AudioProperties::ReadStyle
+            audioPropertiesStyle = AudioProperties::Average);
+
+    /*!
+     * Construct a FileRef from an opened \a IOStream and read only the given
+     * \a parts of the file.
+     *
+     * \note TagLib will *not* take ownership of the stream, the caller is
+     * responsible for deleting it after the File object.
+     *
+     * \see File::ReadParts
+     */
+    FileRef(IOStream* stream, File::ReadParts parts,
+            AudioProperties::ReadStyle
+            audioPropertiesStyle = AudioProperties::Average);
+
     /*!
      * Construct a FileRef using \a file.  The FileRef now takes ownership of the
      * pointer and will delete the File when it passes out of scope.
@@ -201,6 +225,14 @@ namespace TagLib {
      */
     bool save();
 
+    /*!
+     * Saves the file through a temporary file which replaces the original one
+     * when it is complete.  Returns true on success.
+     *
+     * \see File::saveAtomically()
+     */
+    bool saveAtomically();
+
     /*!
      * Adds a FileTypeResolver to the list of those used by TagLib.  Each
      * additional FileTypeResolver is added to the front of a list of resolvers
@@ -275,8 +307,8 @@ namespace TagLib {
                         AudioProperties::ReadStyle audioPropertiesStyle = AudioProperties::Average);
 
   private:
-    void parse(FileName fileName, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle);
-    void parse(IOStream *stream, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle);
+    void parse(FileName fileName, File::ReadParts parts, AudioProperties::ReadStyle audioPropertiesStyle);
+    void parse(IOStream *stream, File::ReadParts parts, AudioProperties::ReadStyle audioPropertiesStyle);
 
     class FileRefPrivate;
     FileRefPrivate *d;
@@ -52,7 +52,6 @@ namespace
   enum { FlacXiphIndex = 0, FlacID3v2Index = 1, FlacID3v1Index = 2 };
 
   const long MinPaddingLength = 4096;
-  const long MaxPaddingLegnth = 1024 * 1024;
 
   const char LastBlockFlag = '\x80';
 }  // namespace
@@ -65,6 +64,7 @@ public:
     ID3v2Location(-1),
     ID3v2OriginalSize(0),
     ID3v1Location(-1),
+    readParts(TagLib::File::ReadAll),
     properties(0),
     flacStart(0),
     streamStart(0),
@@ -84,6 +84,8 @@ public:
 
   long ID3v1Location;
 
+  TagLib::File::ReadParts readParts;
+
   TagUnion tag;
 
   Properties *properties;
@@ -116,7 +118,7 @@ FLAC::File::File(FileName file, bool readProperties, Properties::ReadStyle) :
   d(new FilePrivate())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
 }
 
 FLAC::File::File(FileName file, ID3v2::FrameFactory *frameFactory,
@@ -125,7 +127,7 @@ FLAC::File::File(FileName file, ID3v2::FrameFactory *frameFactory,
   d(new FilePrivate(frameFactory))
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
 }
 
 FLAC::File::File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
@@ -134,7 +136,25 @@ FLAC::File::File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
   d(new FilePrivate(frameFactory))
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
+}
+
+FLAC::File::File(FileName file, ID3v2::FrameFactory *frameFactory,
+                 ReadParts parts, Properties::ReadStyle) :
+  TagLib::File(file),
+  d(new FilePrivate(frameFactory))
+{
+  if(isOpen())
+    read(parts);
+}
+
+FLAC::File::File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
+                 ReadParts parts, Properties::ReadStyle) :
+  TagLib::File(stream),
+  d(new FilePrivate(frameFactory))
+{
+  if(isOpen())
+    read(parts);
 }
 
 FLAC::File::~File()
@@ -179,6 +199,11 @@ bool FLAC::File::save()
     return false;
   }
 
+  if((d->readParts & (ReadTags | ReadPictures)) != (ReadTags | ReadPictures)) {
+    debug("FLAC::File::save() -- The tags or pictures have not been read.");
+    return false;
+  }
+
   // Create new vorbis comments
   if(!hasXiphComment())
     Tag::duplicate(&d->tag, xiphComment(true), false);
@@ -198,7 +223,7 @@ bool FLAC::File::save()
     }
     if(commentBlock && (*it)->code() == MetadataBlock::Picture) {
       // Set the new Vorbis Comment block before the first picture block
-      d->blocks.insert(it, commentBlock);
+      it = d->blocks.insert(it, commentBlock);
       commentBlock = 0;
     }
     ++it;
@@ -219,22 +244,11 @@ bool FLAC::File::save()
 
   // Compute the amount of padding, and append that to data.
 
-  long originalLength = d->streamStart - d->flacStart;
-  long paddingLength = originalLength - data.size() - 4;
-
-  if(paddingLength <= 0) {
-    paddingLength = MinPaddingLength;
-  }
-  else {
-    // Padding won't increase beyond 1% of the file size or 1MB.
-
-    long threshold = length() / 100;
-    threshold = std::max(threshold, MinPaddingLength);
-    threshold = std::min(threshold, MaxPaddingLegnth);
+  // The padding blocks are dropped when reading, but their space is part of
+  // the original length, so it is reused here.
 
-    if(paddingLength > threshold)
-      paddingLength = MinPaddingLength;
-  }
+  long originalLength = d->streamStart - d->flacStart;
+  long paddingLength = paddingSize(originalLength - 4, data.size(), MinPaddingLength);
 
   ByteVector paddingHeader = ByteVector::fromUInt(paddingLength);
   paddingHeader[0] = static_cast<char>(MetadataBlock::Padding | LastBlockFlag);
@@ -259,7 +273,7 @@ bool FLAC::File::save()
     if(d->ID3v2Location < 0)
       d->ID3v2Location = 0;
 
-    data = ID3v2Tag()->render();
+    data = ID3v2Tag()->render(ID3v2::v4, this);
     insert(data, d->ID3v2Location, d->ID3v2OriginalSize);
 
     d->flacStart   += (static_cast<long>(data.size()) - d->ID3v2OriginalSize);
@@ -367,8 +381,15 @@ void FLAC::File::addPicture(Picture *picture)
 void FLAC::File::removePicture(Picture *picture, bool del)
 {
   BlockIterator it = d->blocks.find(picture);
-  if(it != d->blocks.end())
+  if(it != d->blocks.end()) {
+    // A picture handed over to the caller may outlive this file, so its image
+    // data has to be read while the file is still there.
+
+    if(!del)
+      picture->data();
+
     d->blocks.erase(it);
+  }
 
   if(del)
     delete picture;
@@ -420,22 +441,33 @@ bool FLAC::File::hasID3v2Tag() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void FLAC::File::read(bool readProperties)
+void FLAC::File::read(ReadParts parts)
 {
+  d->readParts = parts;
+
+  const bool readTags = (parts & ReadTags) != 0;
+
   // Look for an ID3v2 tag
 
   d->ID3v2Location = Utils::findID3v2(this);
 
   if(d->ID3v2Location >= 0) {
-    d->tag.set(FlacID3v2Index, new ID3v2::Tag(this, d->ID3v2Location, d->ID3v2FrameFactory));
-    d->ID3v2OriginalSize = ID3v2Tag()->header()->completeTagSize();
+    if(readTags) {
+      d->tag.set(FlacID3v2Index, new ID3v2::Tag(this, d->ID3v2Location, d->ID3v2FrameFactory));
+      d->ID3v2OriginalSize = ID3v2Tag()->header()->completeTagSize();
+    }
+    else {
+      seek(d->ID3v2Location);
+      const ID3v2::Header header(readBlock(ID3v2::Header::size()));
+      d->ID3v2OriginalSize = header.completeTagSize();
+    }
   }
 
   // Look for an ID3v1 tag
 
   d->ID3v1Location = Utils::findID3v1(this);
 
-  if(d->ID3v1Location >= 0)
+  if(d->ID3v1Location >= 0 && readTags)
     d->tag.set(FlacID3v1Index, new ID3v1::Tag(this, d->ID3v1Location));
 
   // Look for FLAC metadata, including vorbis comments
@@ -450,7 +482,7 @@ void FLAC::File::read(bool readProperties)
   else
     d->tag.set(FlacXiphIndex, new Ogg::XiphComment());
 
-  if(readProperties) {
+  if(parts & ReadProperties) {
 
     // First block should be the stream_info metadata
 
@@ -493,6 +525,8 @@ void FLAC::File::scan()
   nextBlockOffset += 4;
   d->flacStart = nextBlockOffset;
 
+  const long fileLength = length();
+
   while(true) {
 
     seek(nextBlockOffset);
@@ -535,13 +569,40 @@ void FLAC::File::scan()
       return;
     }
 
-    const ByteVector data = readBlock(blockLength);
-    if(data.size() != blockLength) {
+    if(nextBlockOffset + 4 + static_cast<long>(blockLength) > fileLength) {
       debug("FLAC::File::scan() -- Failed to read a metadata block");
       setValid(false);
       return;
     }
 
+    // The image data of pictures and the contents of padding blocks are
+    // not read here, they can be large.  Comments and pictures which have
+    // not been asked for are skipped entirely.
+
+    const bool skipComment = blockType == MetadataBlock::VorbisComment
+      && !(d->readParts & ReadTags);
+    const bool skipPicture = blockType == MetadataBlock::Picture
+      && !(d->readParts & ReadPictures);
+
+    if(skipComment || skipPicture) {
+      nextBlockOffset += blockLength + 4;
+
+      if(isLastBlock)
+        break;
+
+      continue;
+    }
+
+    ByteVector data;
+    if(blockType != MetadataBlock::Picture && blockType != MetadataBlock::Padding) {
+      data = readBlock(blockLength);
+      if(data.size() != blockLength) {
+        debug("FLAC::File::scan() -- Failed to read a metadata block");
+        setValid(false);
+        return;
+      }
+    }
+
     MetadataBlock *block = 0;
 
     // Found the vorbis-comment
@@ -556,7 +617,7 @@ void FLAC::File::scan()
     }
     else if(blockType == MetadataBlock::Picture) {
       FLAC::Picture *picture = new FLAC::Picture();
-      if(picture->parse(data)) {
+      if(picture->read(this, nextBlockOffset + 4, blockLength)) {
         block = picture;
       }
       else {
@@ -126,6 +126,35 @@ namespace TagLib {
            bool readProperties = true,
            Properties::ReadStyle propertiesStyle = Properties::Average);
 
+      /*!
+       * Constructs a FLAC file from \a file and reads only the given \a parts
+       * of it.  Unless both ReadTags and ReadPictures are given, the file can
+       * not be saved.
+       *
+       * If this file contains and ID3v2 tag the frames will be created using
+       * \a frameFactory.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(FileName file, ID3v2::FrameFactory *frameFactory, ReadParts parts,
+           Properties::ReadStyle propertiesStyle = Properties::Average);
+
+      /*!
+       * Constructs a FLAC file from \a stream and reads only the given
+       * \a parts of it.  Unless both ReadTags and ReadPictures are given, the
+       * file can not be saved.
+       *
+       * \note TagLib will *not* take ownership of the stream, the caller is
+       * responsible for deleting it after the File object.
+       *
+       * If this file contains and ID3v2 tag the frames will be created using
+       * \a frameFactory.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(IOStream *stream, ID3v2::FrameFactory *frameFactory, ReadParts parts,
+           Properties::ReadStyle propertiesStyle = Properties::Average);
+
       /*!
        * Destroys this instance of the File.
        */
@@ -331,7 +360,7 @@ namespace TagLib {
       File(const File &);
       File &operator=(const File &);
 
-      void read(bool readProperties);
+      void read(ReadParts parts);
       void scan();
 
       class FilePrivate;
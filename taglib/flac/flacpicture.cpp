@@ -25,6 +25,7 @@
 
 #include <taglib.h>
 #include <tdebug.h>
+#include <tfile.h>
 #include "flacpicture.h"
 
 using namespace TagLib;
@@ -37,9 +38,60 @@ public:
     width(0),
     height(0),
     colorDepth(0),
-    numColors(0)
+    numColors(0),
+    file(0),
+    dataOffset(0),
+    dataLength(0)
     {}
 
+  // Parses the fields in front of the image data, which has to be included
+  // in the given data up to a length of available bytes.  Returns the offset
+  // of the image data, or 0 if the block is invalid.
+
+  unsigned int parseHeader(const ByteVector &data, unsigned int available)
+  {
+    if(available < 32) {
+      debug("A picture block must contain at least 5 bytes.");
+      return 0;
+    }
+
+    unsigned int pos = 0;
+    type = FLAC::Picture::Type(data.toUInt(pos));
+    pos += 4;
+    const unsigned int mimeTypeLength = data.toUInt(pos);
+    pos += 4;
+    if(mimeTypeLength > available || pos + mimeTypeLength + 24 > available) {
+      debug("Invalid picture block.");
+      return 0;
+    }
+    mimeType = String(data.mid(pos, mimeTypeLength), String::UTF8);
+    pos += mimeTypeLength;
+    const unsigned int descriptionLength = data.toUInt(pos);
+    pos += 4;
+    if(descriptionLength > available || pos + descriptionLength + 20 > available) {
+      debug("Invalid picture block.");
+      return 0;
+    }
+    description = String(data.mid(pos, descriptionLength), String::UTF8);
+    pos += descriptionLength;
+    width = data.toUInt(pos);
+    pos += 4;
+    height = data.toUInt(pos);
+    pos += 4;
+    colorDepth = data.toUInt(pos);
+    pos += 4;
+    numColors = data.toUInt(pos);
+    pos += 4;
+    dataLength = data.toUInt(pos);
+    pos += 4;
+    if(dataLength > available || pos + dataLength > available) {
+      debug("Invalid picture block.");
+      return 0;
+    }
+
+    return pos;
+  }
+
   Type type;
   String mimeType;
   String description;
@@ -48,6 +100,12 @@ public:
   int colorDepth;
   int numColors;
   ByteVector data;
+
+  // The location of image data which has not been read yet.
+
+  TagLib::File *file;
+  long dataOffset;
+  unsigned int dataLength;
 };
 
 FLAC::Picture::Picture() :
@@ -73,45 +131,12 @@ int FLAC::Picture::code() const
 
 bool FLAC::Picture::parse(const ByteVector &data)
 {
-  if(data.size() < 32) {
-    debug("A picture block must contain at least 5 bytes.");
+  const unsigned int pos = d->parseHeader(data, data.size());
+  if(pos == 0)
     return false;
-  }
 
-  unsigned int pos = 0;
-  d->type = FLAC::Picture::Type(data.toUInt(pos));
-  pos += 4;
-  unsigned int mimeTypeLength = data.toUInt(pos);
-  pos += 4;
-  if(pos + mimeTypeLength + 24 > data.size()) {
-    debug("Invalid picture block.");
-    return false;
-  }
-  d->mimeType = String(data.mid(pos, mimeTypeLength), String::UTF8);
-  pos += mimeTypeLength;
-  unsigned int descriptionLength = data.toUInt(pos);
-  pos += 4;
-  if(pos + descriptionLength + 20 > data.size()) {
-    debug("Invalid picture block.");
-    return false;
-  }
-  d->description = String(data.mid(pos, descriptionLength), String::UTF8);
-  pos += descriptionLength;
-  d->width = data.toUInt(pos);
-  pos += 4;
-  d->height = data.toUInt(pos);
-  pos += 4;
-  d->colorDepth = data.toUInt(pos);
-  pos += 4;
-  d->numColors = data.toUInt(pos);
-  pos += 4;
-  unsigned int dataLength = data.toUInt(pos);
-  pos += 4;
-  if(pos + dataLength > data.size()) {
-    debug("Invalid picture block.");
-    return false;
-  }
-  d->data = data.mid(pos, dataLength);
+  d->data = data.mid(pos, d->dataLength);
+  d->file = 0;
 
   return true;
 }
@@ -130,8 +155,9 @@ ByteVector FLAC::Picture::render() const
   result.append(ByteVector::fromUInt(d->height));
   result.append(ByteVector::fromUInt(d->colorDepth));
   result.append(ByteVector::fromUInt(d->numColors));
-  result.append(ByteVector::fromUInt(d->data.size()));
-  result.append(d->data);
+  const ByteVector pictureData = data();
+  result.append(ByteVector::fromUInt(pictureData.size()));
+  result.append(pictureData);
   return result;
 }
 
@@ -207,11 +233,50 @@ void FLAC::Picture::setNumColors(int numColors)
 
 ByteVector FLAC::Picture::data() const
 {
+  if(d->file) {
+    d->file->seek(d->dataOffset);
+    d->data = d->file->readBlock(d->dataLength);
+    d->file = 0;
+  }
+
   return d->data;
 }
 
 void FLAC::Picture::setData(const ByteVector &data)
 {
   d->data = data;
+  d->file = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+bool FLAC::Picture::read(TagLib::File *file, long offset, unsigned int length)
+{
+  // The fields in front of the image data have variable lengths, so they are
+  // read in three steps: up to the MIME type, up to the description and up
+  // to the image data.
+
+  file->seek(offset);
+
+  ByteVector header = file->readBlock(8);
+  if(header.size() == 8 && header.toUInt(4U) < length)
+    header.append(file->readBlock(header.toUInt(4U) + 4));
+
+  if(header.size() >= 12 && header.size() <= length) {
+    const unsigned int descriptionLength = header.toUInt(header.size() - 4);
+    if(descriptionLength < length)
+      header.append(file->readBlock(descriptionLength + 20));
+  }
+
+  const unsigned int pos = (header.size() <= length) ? d->parseHeader(header, length) : 0;
+  if(pos == 0 || pos != header.size())
+    return false;
+
+  d->file = file;
+  d->dataOffset = offset + pos;
+
+  return true;
 }
 
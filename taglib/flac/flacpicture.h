@@ -34,6 +34,8 @@
 
 namespace TagLib {
 
+  class File;
+
   namespace FLAC {
 
     class TAGLIB_EXPORT Picture : public MetadataBlock
@@ -168,6 +170,10 @@ namespace TagLib {
 
       /*!
        * Returns the image data.
+       *
+       * \note The pictures of a FLAC::File are read lazily: only their
+       * description is read when the file is opened, and the image data is
+       * read from the file on the first call of this method.
        */
       ByteVector data() const;
 
@@ -192,9 +198,18 @@ namespace TagLib {
       bool parse(const ByteVector &rawData);
 
     private:
+      friend class File;
+
       Picture(const Picture &item);
       Picture &operator=(const Picture &item);
 
+      /*!
+       * Reads the description of the picture block of \a length bytes at
+       * \a offset in \a file, and remembers where its image data is, so
+       * that it can be read on demand.
+       */
+      bool read(TagLib::File *file, long offset, unsigned int length);
+
       class PicturePrivate;
       PicturePrivate *d;
     };
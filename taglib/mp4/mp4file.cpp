@@ -57,7 +57,9 @@ public:
   FilePrivate() :
     tag(0),
     atoms(0),
-    properties(0) {}
+    properties(0),
+    readParts(TagLib::File::ReadAll),
+    saveStrategy(InsertMetadata) {}
 
   ~FilePrivate()
   {
@@ -69,6 +71,9 @@ public:
   MP4::Tag        *tag;
   MP4::Atoms      *atoms;
   MP4::Properties *properties;
+
+  TagLib::File::ReadParts readParts;
+  SaveStrategy saveStrategy;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -92,7 +97,7 @@ MP4::File::File(FileName file, bool readProperties, AudioProperties::ReadStyle)
   d(new FilePrivate())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
 }
 
 MP4::File::File(IOStream *stream, bool readProperties, AudioProperties::ReadStyle) :
@@ -100,7 +105,23 @@ MP4::File::File(IOStream *stream, bool readProperties, AudioProperties::ReadStyl
   d(new FilePrivate())
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
+}
+
+MP4::File::File(FileName file, ReadParts parts, AudioProperties::ReadStyle) :
+  TagLib::File(file),
+  d(new FilePrivate())
+{
+  if(isOpen())
+    read(parts);
+}
+
+MP4::File::File(IOStream *stream, ReadParts parts, AudioProperties::ReadStyle) :
+  TagLib::File(stream),
+  d(new FilePrivate())
+{
+  if(isOpen())
+    read(parts);
 }
 
 MP4::File::~File()
@@ -136,8 +157,10 @@ MP4::File::audioProperties() const
 }
 
 void
-MP4::File::read(bool readProperties)
+MP4::File::read(ReadParts parts)
 {
+  d->readParts = parts;
+
   if(!isValid())
     return;
 
@@ -153,8 +176,14 @@ MP4::File::read(bool readProperties)
     return;
   }
 
-  d->tag = new Tag(this, d->atoms);
-  if(readProperties) {
+  // The atom tree itself is always read, since saving the file needs it.
+
+  if(parts & ReadTags)
+    d->tag = new Tag(this, d->atoms, (parts & ReadPictures) != 0);
+  else
+    d->tag = new Tag();
+
+  if(parts & ReadProperties) {
     d->properties = new Properties(this, d->atoms);
   }
 }
@@ -172,9 +201,27 @@ MP4::File::save()
     return false;
   }
 
+  if((d->readParts & (ReadTags | ReadPictures)) != (ReadTags | ReadPictures)) {
+    debug("MP4::File::save() -- The tags or pictures have not been read.");
+    return false;
+  }
+
+  d->tag->setMoveMoovToEnd(d->saveStrategy == MoveMetadataToEnd);
   return d->tag->save();
 }
 
+void
+MP4::File::setSaveStrategy(SaveStrategy strategy)
+{
+  d->saveStrategy = strategy;
+}
+
+MP4::File::SaveStrategy
+MP4::File::saveStrategy() const
+{
+  return d->saveStrategy;
+}
+
 bool
 MP4::File::hasMP4Tag() const
 {
@@ -48,6 +48,24 @@ namespace TagLib {
     class TAGLIB_EXPORT File : public TagLib::File
     {
     public:
+      /*!
+       * How save() makes room for metadata which has outgrown the space and
+       * padding it had before.
+       */
+      enum SaveStrategy {
+        //! Insert the bytes into the 'moov' atom, moving all the data which
+        //! follows it.  This is the default.
+        InsertMetadata,
+        //! If the media data follows the 'moov' atom, turn the 'moov' atom into
+        //! a 'free' atom and append the updated one to the end of the file.
+        //! The media data is never moved, so saving takes time proportional to
+        //! the size of the metadata rather than of the file.  Players which
+        //! stream the file progressively need the 'moov' atom in front of the
+        //! media data, though.  Fragmented files are always saved with
+        //! InsertMetadata.
+        MoveMetadataToEnd
+      };
+
       /*!
        * Constructs an MP4 file from \a file.  If \a readProperties is true the
        * file's audio properties will also be read.
@@ -69,6 +87,29 @@ namespace TagLib {
       File(IOStream *stream, bool readProperties = true,
            Properties::ReadStyle audioPropertiesStyle = Properties::Average);
 
+      /*!
+       * Constructs an MP4 file from \a file and reads only the given \a parts
+       * of it.  Unless both ReadTags and ReadPictures are given, the file can
+       * not be saved.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(FileName file, ReadParts parts,
+           Properties::ReadStyle audioPropertiesStyle = Properties::Average);
+
+      /*!
+       * Constructs an MP4 file from \a stream and reads only the given
+       * \a parts of it.  Unless both ReadTags and ReadPictures are given, the
+       * file can not be saved.
+       *
+       * \note TagLib will *not* take ownership of the stream, the caller is
+       * responsible for deleting it after the File object.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(IOStream *stream, ReadParts parts,
+           Properties::ReadStyle audioPropertiesStyle = Properties::Average);
+
       /*!
        * Destroys this instance of the File.
        */
@@ -114,6 +155,18 @@ namespace TagLib {
        */
       bool save();
 
+      /*!
+       * Sets how save() makes room for metadata which has grown.
+       *
+       * \see SaveStrategy
+       */
+      void setSaveStrategy(SaveStrategy strategy);
+
+      /*!
+       * Returns the strategy set by setSaveStrategy().
+       */
+      SaveStrategy saveStrategy() const;
+
       /*!
        * Returns whether or not the file on disk actually has an MP4 tag, or the
        * file has a Metadata Item List (ilst) atom.
@@ -130,7 +183,7 @@ namespace TagLib {
       static bool isSupported(IOStream *stream);
 
     private:
-      void read(bool readProperties);
+      void read(ReadParts parts);
 
       class FilePrivate;
       FilePrivate *d;
@@ -22,6 +22,7 @@
  *   License Version 1.1.  You may obtain a copy of the License at         *
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
+#include <algorithm>
 #include <cstring>
 #include <tdebug.h>
 #include <tstring.h>
@@ -33,16 +34,81 @@
 
 using namespace TagLib;
 
+namespace
+{
+  // The default padding fills the 'ilst' atom up to the next 1KB boundary.
+
+  long alignmentPadding(const ByteVector &data)
+  {
+    return ((data.size() + 1023) & ~1023) - data.size();
+  }
+
+  // Moves the absolute file offset \a o by \a delta if it is beyond \a offset,
+  // where \a delta bytes have been inserted.
+
+  long long movedOffset(long long o, long delta, long offset)
+  {
+    return (o > offset) ? o + delta : o;
+  }
+
+  // Updates \a count big-endian file offsets of \a size (4 or 8) bytes which
+  // are stored from \a pos in \a data, all in memory.
+
+  void updateOffsetTable(ByteVector &data, unsigned int pos, unsigned int count,
+                         unsigned int size, long delta, long offset)
+  {
+    if(pos > data.size())
+      return;
+
+    count = std::min(count, (data.size() - pos) / size);
+
+    unsigned char *p = reinterpret_cast<unsigned char *>(data.data() + pos);
+    unsigned char *end = p + count * size;
+
+    if(size == 4) {
+      for(; p < end; p += 4) {
+        unsigned int o = (static_cast<unsigned int>(p[0]) << 24) |
+                         (static_cast<unsigned int>(p[1]) << 16) |
+                         (static_cast<unsigned int>(p[2]) << 8) |
+                         (static_cast<unsigned int>(p[3]));
+        if(static_cast<long>(o) > offset) {
+          o += static_cast<unsigned int>(delta);
+          p[0] = static_cast<unsigned char>(o >> 24);
+          p[1] = static_cast<unsigned char>(o >> 16);
+          p[2] = static_cast<unsigned char>(o >> 8);
+          p[3] = static_cast<unsigned char>(o);
+        }
+      }
+    }
+    else {
+      for(; p < end; p += 8) {
+        unsigned long long o = 0;
+        for(int i = 0; i < 8; ++i)
+          o = (o << 8) | p[i];
+        if(static_cast<long long>(o) > offset) {
+          o += static_cast<unsigned long long>(static_cast<long long>(delta));
+          for(int i = 7; i >= 0; --i) {
+            p[i] = static_cast<unsigned char>(o);
+            o >>= 8;
+          }
+        }
+      }
+    }
+  }
+}
+
 class MP4::Tag::TagPrivate
 {
 public:
   TagPrivate() :
     file(0),
-    atoms(0) {}
+    atoms(0),
+    moveMoovToEnd(false) {}
 
   TagLib::File *file;
   Atoms *atoms;
   ItemMap items;
+  bool moveMoovToEnd;
 };
 
 MP4::Tag::Tag() :
@@ -56,7 +122,27 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms) :
   d->file = file;
   d->atoms = atoms;
 
-  MP4::Atom *ilst = atoms->find("moov", "udta", "meta", "ilst");
+  read(true);
+}
+
+MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms, bool readPictures) :
+  d(new TagPrivate())
+{
+  d->file = file;
+  d->atoms = atoms;
+
+  read(readPictures);
+}
+
+MP4::Tag::~Tag()
+{
+  delete d;
+}
+
+void
+MP4::Tag::read(bool readPictures)
+{
+  MP4::Atom *ilst = d->atoms->find("moov", "udta", "meta", "ilst");
   if(!ilst) {
     //debug("Atom moov.udta.meta.ilst not found.");
     return;
@@ -64,7 +150,9 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms) :
 
   for(AtomList::ConstIterator it = ilst->children.begin(); it != ilst->children.end(); ++it) {
     MP4::Atom *atom = *it;
-    file->seek(atom->offset + 8);
+    if(atom->name == "covr" && !readPictures)
+      continue;
+    d->file->seek(atom->offset + 8);
     if(atom->name == "----") {
       parseFreeForm(atom);
     }
@@ -115,11 +203,6 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms) :
   }
 }
 
-MP4::Tag::~Tag()
-{
-  delete d;
-}
-
 MP4::AtomDataList
 MP4::Tag::parseData2(const MP4::Atom *atom, int expectedFlags, bool freeForm)
 {
@@ -333,7 +416,7 @@ ByteVector
 MP4::Tag::padIlst(const ByteVector &data, int length) const
 {
   if(length == -1) {
-    length = ((data.size() + 1023) & ~1023) - data.size();
+    length = alignmentPadding(data);
   }
   return renderAtom("free", ByteVector(length, '\1'));
 }
@@ -573,6 +656,8 @@ MP4::Tag::updateParents(const AtomList &path, long delta, int ignore)
 void
 MP4::Tag::updateOffsets(long delta, long offset)
 {
+  // Each offset table is read, updated in memory and written back as a whole.
+
   MP4::Atom *moov = d->atoms->find("moov");
   if(moov) {
     MP4::AtomList stco = moov->findall("stco", true);
@@ -583,17 +668,9 @@ MP4::Tag::updateOffsets(long delta, long offset)
       }
       d->file->seek(atom->offset + 12);
       ByteVector data = d->file->readBlock(atom->length - 12);
-      unsigned int count = data.toUInt();
-      d->file->seek(atom->offset + 16);
-      unsigned int pos = 4;
-      while(count--) {
-        long o = static_cast<long>(data.toUInt(pos));
-        if(o > offset) {
-          o += delta;
-        }
-        d->file->writeBlock(ByteVector::fromUInt(o));
-        pos += 4;
-      }
+      updateOffsetTable(data, 4, data.toUInt(), 4, delta, offset);
+      d->file->seek(atom->offset + 12);
+      d->file->writeBlock(data);
     }
 
     MP4::AtomList co64 = moov->findall("co64", true);
@@ -604,50 +681,144 @@ MP4::Tag::updateOffsets(long delta, long offset)
       }
       d->file->seek(atom->offset + 12);
       ByteVector data = d->file->readBlock(atom->length - 12);
-      unsigned int count = data.toUInt();
-      d->file->seek(atom->offset + 16);
-      unsigned int pos = 4;
-      while(count--) {
-        long long o = data.toLongLong(pos);
-        if(o > offset) {
-          o += delta;
-        }
-        d->file->writeBlock(ByteVector::fromLongLong(o));
-        pos += 8;
-      }
+      updateOffsetTable(data, 4, data.toUInt(), 8, delta, offset);
+      d->file->seek(atom->offset + 12);
+      d->file->writeBlock(data);
     }
   }
 
-  MP4::Atom *moof = d->atoms->find("moof");
-  if(moof) {
-    MP4::AtomList tfhd = moof->findall("tfhd", true);
-    for(MP4::AtomList::ConstIterator it = tfhd.begin(); it != tfhd.end(); ++it) {
-      MP4::Atom *atom = *it;
-      if(atom->offset > offset) {
-        atom->offset += delta;
+  // Fragmented files have a 'moof' atom for each fragment, and may index them
+  // with 'sidx' and 'mfra' atoms.
+
+  for(AtomList::ConstIterator it = d->atoms->atoms.begin(); it != d->atoms->atoms.end(); ++it) {
+    MP4::Atom *atom = *it;
+    if(atom->name == "moof") {
+      updateFragmentOffsets(atom, delta, offset);
+    }
+    else if(atom->name == "sidx") {
+      updateSegmentIndexOffsets(atom, delta, offset);
+    }
+    else if(atom->name == "mfra") {
+      updateRandomAccessOffsets(atom, delta, offset);
+    }
+  }
+}
+
+void
+MP4::Tag::updateFragmentOffsets(MP4::Atom *moof, long delta, long offset)
+{
+  MP4::AtomList tfhd = moof->findall("tfhd", true);
+  for(MP4::AtomList::ConstIterator it = tfhd.begin(); it != tfhd.end(); ++it) {
+    MP4::Atom *atom = *it;
+    if(atom->offset > offset) {
+      atom->offset += delta;
+    }
+    d->file->seek(atom->offset + 9);
+    ByteVector data = d->file->readBlock(atom->length - 9);
+    const unsigned int flags = data.toUInt(0, 3, true);
+    if(flags & 1) {
+      long long o = data.toLongLong(7U);
+      if(o > offset) {
+        o += delta;
       }
-      d->file->seek(atom->offset + 9);
-      ByteVector data = d->file->readBlock(atom->length - 9);
-      const unsigned int flags = data.toUInt(0, 3, true);
-      if(flags & 1) {
-        long long o = data.toLongLong(7U);
-        if(o > offset) {
-          o += delta;
-        }
-        d->file->seek(atom->offset + 16);
-        d->file->writeBlock(ByteVector::fromLongLong(o));
+      d->file->seek(atom->offset + 16);
+      d->file->writeBlock(ByteVector::fromLongLong(o));
+    }
+  }
+}
+
+void
+MP4::Tag::updateSegmentIndexOffsets(MP4::Atom *sidx, long delta, long offset)
+{
+  // The first offset of a 'sidx' atom is relative to the end of the atom, so
+  // it only changes if the data has been inserted between them.
+
+  const long long anchor = sidx->offset + sidx->length;
+
+  if(sidx->offset > offset) {
+    sidx->offset += delta;
+  }
+
+  // The first offset follows the earliest presentation time, both of which
+  // are 64-bit in version 1.
+
+  d->file->seek(sidx->offset + 8);
+  const ByteVector data = d->file->readBlock(28);
+  if(data.isEmpty())
+    return;
+
+  const bool version1 = (data[0] != 0);
+  const unsigned int pos = version1 ? 20 : 16;
+  if(data.size() < pos + (version1 ? 8 : 4))
+    return;
+
+  const long long firstOffset = version1 ? data.toLongLong(pos) : data.toUInt(pos);
+  const long long updated = movedOffset(anchor + firstOffset, delta, offset)
+                          - movedOffset(anchor, delta, offset);
+
+  if(updated != firstOffset) {
+    d->file->seek(sidx->offset + 8 + pos);
+    if(version1)
+      d->file->writeBlock(ByteVector::fromLongLong(updated));
+    else
+      d->file->writeBlock(ByteVector::fromUInt(static_cast<unsigned int>(updated)));
+  }
+}
+
+void
+MP4::Tag::updateRandomAccessOffsets(MP4::Atom *mfra, long delta, long offset)
+{
+  // 'mfra' is not parsed as a container, so its 'tfra' children are looked up
+  // in its data.
+
+  if(mfra->offset > offset) {
+    mfra->offset += delta;
+  }
+
+  d->file->seek(mfra->offset + 8);
+  ByteVector data = d->file->readBlock(mfra->length - 8);
+
+  unsigned int pos = 0;
+  while(pos + 24 <= data.size()) {
+    const unsigned int length = data.toUInt(pos);
+    if(length < 8 || length > data.size() - pos)
+      break;
+
+    if(data.containsAt("tfra", pos + 4)) {
+      const bool version1 = (data[pos + 8] != 0);
+      const unsigned int sizes = data.toUInt(pos + 16);
+      const unsigned int count = data.toUInt(pos + 20);
+
+      // Each entry has a time and a 'moof' offset, followed by the numbers of
+      // the traf, trun and sample, whose sizes are given by 'sizes'.
+
+      const unsigned int offsetSize = version1 ? 8 : 4;
+      const unsigned int entrySize = offsetSize * 2 +
+        ((sizes >> 4) & 0x03) + ((sizes >> 2) & 0x03) + (sizes & 0x03) + 3;
+
+      unsigned int entry = pos + 24;
+      for(unsigned int i = 0; i < count && entry + entrySize <= pos + length; ++i) {
+        updateOffsetTable(data, entry + offsetSize, 1, offsetSize, delta, offset);
+        entry += entrySize;
       }
     }
+
+    pos += length;
   }
+
+  d->file->seek(mfra->offset + 8);
+  d->file->writeBlock(data);
 }
 
 void
 MP4::Tag::saveNew(ByteVector data)
 {
+  const long padding = d->file->paddingSize(0, data.size(), alignmentPadding(data));
+
   data = renderAtom("meta", ByteVector(4, '\0') +
                     renderAtom("hdlr", ByteVector(8, '\0') + ByteVector("mdirappl") +
                                ByteVector(9, '\0')) +
-                    data + padIlst(data));
+                    data + padIlst(data, static_cast<int>(padding)));
 
   AtomList path = d->atoms->path("moov", "udta");
   if(path.size() != 2) {
@@ -656,6 +827,10 @@ MP4::Tag::saveNew(ByteVector data)
   }
 
   long offset = path.back()->offset + 8;
+
+  if(moveMoovToEnd(data, offset, 0, path))
+    return;
+
   d->file->insert(data, offset, 0);
 
   updateParents(path, data.size());
@@ -699,14 +874,25 @@ MP4::Tag::saveExisting(ByteVector data, const AtomList &path)
     }
   }
 
-  long delta = data.size() - length;
-  if(delta > 0 || (delta < 0 && delta > -8)) {
-    data.append(padIlst(data));
-    delta = data.size() - length;
+  // Fill the space left over with a 'free' atom, which needs 8 bytes.
+
+  // Shrinking the padding moves the media data and rewrites all the chunk
+  // offsets, so the space is kept unless a padding policy asks otherwise.
+
+  if(static_cast<long>(data.size()) != length) {
+    long padding = length - 8 - data.size();
+    if(padding < 0 || d->file->hasPaddingPolicy())
+      padding = d->file->paddingSize(length - 8, data.size(), alignmentPadding(data));
+    data.append(padIlst(data, static_cast<int>(padding)));
   }
-  else if(delta < 0) {
-    data.append(padIlst(data, -delta - 8));
-    delta = 0;
+
+  const long delta = data.size() - length;
+
+  if(delta > 0) {
+    AtomList parents = path;
+    parents.erase(--parents.end());
+    if(moveMoovToEnd(data, offset, length, parents))
+      return;
   }
 
   d->file->insert(data, offset, length);
@@ -717,6 +903,107 @@ MP4::Tag::saveExisting(ByteVector data, const AtomList &path)
   }
 }
 
+bool
+MP4::Tag::moveMoovToEnd(const ByteVector &data, long offset, long length,
+                        const AtomList &parents)
+{
+  if(!d->moveMoovToEnd || parents.isEmpty())
+    return false;
+
+  MP4::Atom *moov = parents.front();
+
+  // Nothing is gained unless media data follows the 'moov' atom.  Fragmented
+  // files are left alone, since their 'mfra' atom has to stay the last one,
+  // and so are files whose last atom extends to the end of the file.  If
+  // anything else, like an ID3v1 tag, follows the last atom, an appended
+  // atom could not be found.
+
+  bool hasMediaData = false;
+  for(AtomList::ConstIterator it = d->atoms->atoms.begin(); it != d->atoms->atoms.end(); ++it) {
+    if((*it)->name == "moof" || (*it)->name == "mfra")
+      return false;
+    if((*it)->name == "mdat" && (*it)->offset > moov->offset)
+      hasMediaData = true;
+  }
+
+  if(!hasMediaData)
+    return false;
+
+  const MP4::Atom *last = d->atoms->atoms.back();
+  const long newOffset = last->offset + last->length;
+  if(newOffset != d->file->length())
+    return false;
+
+  d->file->seek(last->offset);
+  if(d->file->readBlock(4).toUInt() == 0)
+    return false;
+
+  // Render the new 'moov' atom in memory.  Its size on disk is read again, as
+  // the atom tree is not updated by the previous saves.
+
+  d->file->seek(moov->offset);
+  const ByteVector header = d->file->readBlock(16);
+  if(header.size() < 16)
+    return false;
+
+  const long moovLength = (header.toUInt() == 1)
+    ? static_cast<long>(header.toLongLong(8U)) : static_cast<long>(header.toUInt());
+  const long pos = offset - moov->offset;
+
+  if(pos < 0 || pos + length > moovLength)
+    return false;
+
+  d->file->seek(moov->offset);
+  const ByteVector oldMoov = d->file->readBlock(moovLength);
+  if(static_cast<long>(oldMoov.size()) != moovLength)
+    return false;
+
+  const long delta = data.size() - length;
+
+  ByteVector newMoov = oldMoov.mid(0, pos);
+  newMoov.append(data);
+  newMoov.append(oldMoov.mid(pos + length));
+
+  for(AtomList::ConstIterator it = parents.begin(); it != parents.end(); ++it) {
+    const unsigned int atomPos = (*it)->offset - moov->offset;
+    const unsigned int size = newMoov.toUInt(atomPos);
+    if(size == 1) {
+      const ByteVector v = ByteVector::fromLongLong(newMoov.toLongLong(atomPos + 8) + delta);
+      ::memcpy(newMoov.data() + atomPos + 8, v.data(), 8);
+    }
+    else {
+      const ByteVector v = ByteVector::fromUInt(size + delta);
+      ::memcpy(newMoov.data() + atomPos, v.data(), 4);
+    }
+  }
+
+  // Append the new 'moov' atom before the old one is turned into a 'free'
+  // atom, so that the file always has a valid 'moov' atom.  The chunk offsets
+  // stay valid, as the media data does not move.
+
+  d->file->seek(newOffset);
+  d->file->writeBlock(newMoov);
+
+  d->file->seek(moov->offset + 4);
+  d->file->writeBlock("free");
+
+  // Update the atom tree.
+
+  moov->name = "free";
+  moov->children.clear();
+
+  d->file->seek(newOffset);
+  d->atoms->atoms.append(new Atom(d->file));
+
+  return true;
+}
+
+void
+MP4::Tag::setMoveMoovToEnd(bool move)
+{
+  d->moveMoovToEnd = move;
+}
+
 String
 MP4::Tag::title() const
 {
@@ -47,9 +47,16 @@ namespace TagLib {
 
     class TAGLIB_EXPORT Tag: public TagLib::Tag
     {
+      friend class File;
+
     public:
         Tag();
         Tag(TagLib::File *file, Atoms *atoms);
+        /*!
+         * Reads the tag from \a file.  If \a readPictures is false, the cover
+         * art is skipped.
+         */
+        Tag(TagLib::File *file, Atoms *atoms, bool readPictures);
         virtual ~Tag();
         bool save();
 
@@ -130,6 +137,7 @@ namespace TagLib {
         void parseIntPair(const Atom *atom);
         void parseBool(const Atom *atom);
         void parseCovr(const Atom *atom);
+        void read(bool readPictures);
 
         ByteVector padIlst(const ByteVector &data, int length = -1) const;
         ByteVector renderAtom(const ByteVector &name, const ByteVector &data) const;
@@ -149,9 +157,15 @@ namespace TagLib {
 
         void updateParents(const AtomList &path, long delta, int ignore = 0);
         void updateOffsets(long delta, long offset);
+        void updateFragmentOffsets(Atom *moof, long delta, long offset);
+        void updateSegmentIndexOffsets(Atom *sidx, long delta, long offset);
+        void updateRandomAccessOffsets(Atom *mfra, long delta, long offset);
 
         void saveNew(ByteVector data);
         void saveExisting(ByteVector data, const AtomList &path);
+        bool moveMoovToEnd(const ByteVector &data, long offset, long length,
+                           const AtomList &parents);
+        void setMoveMoovToEnd(bool move);
 
         void addItem(const String &name, const Item &value);
 
@@ -188,6 +188,19 @@ void Frame::setText(const String &)
 ByteVector Frame::render() const
 {
   ByteVector fieldData = renderFields();
+
+  if(d->header->compression() && !d->header->encryption() && zlib::isAvailable()) {
+
+    // The size of the uncompressed data is prepended, as a data length
+    // indicator in ID3v2.4.
+
+    const ByteVector dataLength = d->header->version() >= 4
+      ? SynchData::fromUInt(fieldData.size())
+      : ByteVector::fromUInt(fieldData.size());
+
+    fieldData = dataLength + zlib::compress(fieldData);
+  }
+
   d->header->setFrameSize(fieldData.size());
   ByteVector headerData = d->header->render();
 
@@ -241,7 +254,9 @@ ByteVector Frame::fieldData(const ByteVector &frameData) const
   unsigned int frameDataLength = size();
 
   if(d->header->compression() || d->header->dataLengthIndicator()) {
-    frameDataLength = SynchData::toUInt(frameData.mid(headerSize, 4));
+    frameDataLength = d->header->version() >= 4
+      ? SynchData::toUInt(frameData.mid(headerSize, 4))
+      : frameData.toUInt(headerSize, true);
     frameDataOffset += 4;
   }
 
@@ -251,7 +266,7 @@ ByteVector Frame::fieldData(const ByteVector &frameData) const
       return ByteVector();
     }
 
-    const ByteVector outData = zlib::decompress(frameData.mid(frameDataOffset));
+    const ByteVector outData = zlib::decompress(frameData.mid(frameDataOffset), frameDataLength);
     if(!outData.isEmpty() && frameDataLength != outData.size()) {
       debug("frameDataLength does not match the data length returned by zlib");
     }
@@ -792,6 +807,11 @@ bool Frame::Header::compression() const
   return d->compression;
 }
 
+void Frame::Header::setCompression(bool compress)
+{
+  d->compression = compress;
+}
+
 bool Frame::Header::encryption() const
 {
   return d->encryption;
@@ -814,7 +834,12 @@ bool Frame::Header::dataLengthIndicator() const
 
 ByteVector Frame::Header::render() const
 {
-  ByteVector flags(2, char(0)); // just blank for the moment
+  // Only the flags for compression are rendered for the moment.
+
+  ByteVector flags(2, char(0));
+
+  if(d->compression && !d->encryption && zlib::isAvailable())
+    flags[1] = d->version == 3 ? '\x80' : '\x09';
 
   ByteVector v = d->frameID +
     (d->version == 3
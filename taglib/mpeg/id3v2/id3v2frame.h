@@ -472,10 +472,19 @@ namespace TagLib {
       /*!
        * Returns true if compression is enabled for this frame.
        *
-       * \note This flag is currently ignored internally in TagLib.
+       * \see setCompression()
        */
       bool compression() const;
 
+      /*!
+       * Sets whether the frame data is compressed with zlib when the frame is
+       * rendered.  Frames which were read compressed are written back
+       * compressed.  This has no effect if TagLib is built without zlib.
+       *
+       * \see compression()
+       */
+      void setCompression(bool compress);
+
       /*!
        * Returns true if encryption is enabled for this frame.
        *
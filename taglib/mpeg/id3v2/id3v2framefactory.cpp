@@ -23,7 +23,11 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include <tdebug.h>
+#include <tmap.h>
 #include <tzlib.h>
 
 #include "id3v2framefactory.h"
@@ -97,239 +101,166 @@ public:
   String::Type defaultEncoding;
   bool useDefaultEncoding;
 
-  template <class T> void setTextEncoding(T *frame)
+  Map<ByteVector, FrameCreator> customFrameTypes;
+
+  template <class T> void setTextEncoding(T *frame) const
   {
     if(useDefaultEncoding)
       frame->setTextEncoding(defaultEncoding);
   }
-};
-
-FrameFactory FrameFactory::factory;
-
-////////////////////////////////////////////////////////////////////////////////
-// public members
-////////////////////////////////////////////////////////////////////////////////
-
-FrameFactory *FrameFactory::instance()
-{
-  return &factory;
-}
-
-Frame *FrameFactory::createFrame(const ByteVector &data, bool synchSafeInts) const
-{
-  return createFrame(data, static_cast<unsigned int>(synchSafeInts ? 4 : 3));
-}
 
-Frame *FrameFactory::createFrame(const ByteVector &data, unsigned int version) const
-{
-  Header tagHeader;
-  tagHeader.setMajorVersion(version);
-  return createFrame(data, &tagHeader);
-}
+  // The built-in frame types, sorted by their frame IDs.  ID3v2.2 IDs which
+  // have no ID3v2.4 equivalent are padded with zeros.
 
-Frame *FrameFactory::createFrame(const ByteVector &origData, Header *tagHeader) const
-{
-    return createFrame(origData, const_cast<const Header *>(tagHeader));
-}
-
-Frame *FrameFactory::createFrame(const ByteVector &origData, const Header *tagHeader) const
-{
-  ByteVector data = origData;
-  unsigned int version = tagHeader->majorVersion();
-  Frame::Header *header = new Frame::Header(data, version);
-  ByteVector frameID = header->frameID();
-
-  // A quick sanity check -- make sure that the frameID is 4 uppercase Latin1
-  // characters.  Also make sure that there is data in the frame.
+  typedef Frame *(*Creator)(const FrameFactoryPrivate *d, const ByteVector &data,
+                            Frame::Header *header, const Header *tagHeader);
 
-  if(frameID.size() != (version < 3 ? 3 : 4) ||
-     header->frameSize() <= static_cast<unsigned int>(header->dataLengthIndicator() ? 4 : 0) ||
-     header->frameSize() > data.size())
+  struct FrameType
   {
-    delete header;
-    return 0;
-  }
-
-#ifndef NO_ITUNES_HACKS
-  if(version == 3 && frameID.size() == 4 && frameID[3] == '\0') {
-    // iTunes v2.3 tags store v2.2 frames - convert now
-    frameID = frameID.mid(0, 3);
-    header->setFrameID(frameID);
-    header->setVersion(2);
-    updateFrame(header);
-    header->setVersion(3);
-  }
-#endif
+    char frameID[4];
+    Creator create;
+  };
 
-  for(ByteVector::ConstIterator it = frameID.begin(); it != frameID.end(); it++) {
-    if( (*it < 'A' || *it > 'Z') && (*it < '0' || *it > '9') ) {
-      delete header;
-      return 0;
-    }
-  }
+  static const FrameType frameTypes[];
+  static const FrameType *const frameTypesEnd;
 
-  if(version > 3 && (tagHeader->unsynchronisation() || header->unsynchronisation())) {
-    // Data lengths are not part of the encoded data, but since they are synch-safe
-    // integers they will be never actually encoded.
-    ByteVector frameData = data.mid(Frame::Header::size(version), header->frameSize());
-    frameData = SynchData::decode(frameData);
-    data = data.mid(0, Frame::Header::size(version)) + frameData;
+  static bool frameTypeLess(const FrameType &type, const char *frameID)
+  {
+    return ::memcmp(type.frameID, frameID, 4) < 0;
   }
 
-  // TagLib doesn't mess with encrypted frames, so just treat them
-  // as unknown frames.
+  static const FrameType *findFrameType(const ByteVector &frameID)
+  {
+    char key[4] = { 0, 0, 0, 0 };
+    std::copy(frameID.begin(), frameID.begin() + std::min(frameID.size(), 4U), key);
 
-  if(!zlib::isAvailable() && header->compression()) {
-    debug("Compressed frames are currently not supported.");
-    return new UnknownFrame(data, header);
-  }
+    const FrameType *type = std::lower_bound(frameTypes, frameTypesEnd, key, frameTypeLess);
+    if(type != frameTypesEnd && ::memcmp(type->frameID, key, 4) == 0)
+      return type;
 
-  if(header->encryption()) {
-    debug("Encrypted frames are currently not supported.");
-    return new UnknownFrame(data, header);
+    return 0;
   }
 
-  if(!updateFrame(header)) {
-    header->setTagAlterPreservation(true);
-    return new UnknownFrame(data, header);
+  template <class T>
+  static Frame *create(const FrameFactoryPrivate *, const ByteVector &data,
+                       Frame::Header *header, const Header *)
+  {
+    return new T(data, header);
   }
 
-  // updateFrame() might have updated the frame ID.
-
-  frameID = header->frameID();
-
-  // This is where things get necissarily nasty.  Here we determine which
-  // Frame subclass (or if none is found simply an Frame) based
-  // on the frame ID.  Since there are a lot of possibilities, that means
-  // a lot of if blocks.
-
-  // Text Identification (frames 4.2)
-
-  // Apple proprietary WFED (Podcast URL), MVNM (Movement Name), MVIN (Movement Number), GRP1 (Grouping) are in fact text frames.
-  if(frameID.startsWith("T") || frameID == "WFED" || frameID == "MVNM" || frameID == "MVIN" || frameID == "GRP1") {
-
-    TextIdentificationFrame *f = frameID != "TXXX"
-      ? new TextIdentificationFrame(data, header)
-      : new UserTextIdentificationFrame(data, header);
-
+  template <class T>
+  static Frame *createWithEncoding(const FrameFactoryPrivate *d, const ByteVector &data,
+                                   Frame::Header *header, const Header *)
+  {
+    T *f = new T(data, header);
     d->setTextEncoding(f);
-
-    if(frameID == "TCON")
-      updateGenre(f);
-
     return f;
   }
 
-  // Comments (frames 4.10)
-
-  if(frameID == "COMM") {
-    CommentsFrame *f = new CommentsFrame(data, header);
-    d->setTextEncoding(f);
-    return f;
+  template <class T>
+  static Frame *createWithTagHeader(const FrameFactoryPrivate *, const ByteVector &data,
+                                    Frame::Header *header, const Header *tagHeader)
+  {
+    return new T(tagHeader, data, header);
   }
 
-  // Attached Picture (frames 4.14)
-
-  if(frameID == "APIC") {
-    AttachedPictureFrame *f = new AttachedPictureFrame(data, header);
+  static Frame *createGenre(const FrameFactoryPrivate *d, const ByteVector &data,
+                            Frame::Header *header, const Header *)
+  {
+    TextIdentificationFrame *f = new TextIdentificationFrame(data, header);
     d->setTextEncoding(f);
+    updateGenre(f);
     return f;
   }
+};
 
+const FrameFactory::FrameFactoryPrivate::FrameType
+FrameFactory::FrameFactoryPrivate::frameTypes[] = {
+  // Attached Picture (frames 4.14)
+  { { 'A', 'P', 'I', 'C' }, &createWithEncoding<AttachedPictureFrame> },
+  // Chapter (ID3v2 chapters 1.0)
+  { { 'C', 'H', 'A', 'P' }, &createWithTagHeader<ChapterFrame> },
+  // Comments (frames 4.10)
+  { { 'C', 'O', 'M', 'M' }, &createWithEncoding<CommentsFrame> },
+  // Table of contents (ID3v2 chapters 1.0)
+  { { 'C', 'T', 'O', 'C' }, &createWithTagHeader<TableOfContentsFrame> },
+  // Event timing codes (frames 4.5)
+  { { 'E', 'T', 'C', 'O' }, &create<EventTimingCodesFrame> },
+  // General Encapsulated Object (frames 4.15)
+  { { 'G', 'E', 'O', 'B' }, &createWithEncoding<GeneralEncapsulatedObjectFrame> },
+  // Apple proprietary GRP1 (Grouping), a text frame
+  { { 'G', 'R', 'P', '1' }, &createWithEncoding<TextIdentificationFrame> },
+  // Apple proprietary MVIN (Movement Number), a text frame
+  { { 'M', 'V', 'I', 'N' }, &createWithEncoding<TextIdentificationFrame> },
+  // Apple proprietary MVNM (Movement Name), a text frame
+  { { 'M', 'V', 'N', 'M' }, &createWithEncoding<TextIdentificationFrame> },
+  // Ownership (frames 4.22)
+  { { 'O', 'W', 'N', 'E' }, &createWithEncoding<OwnershipFrame> },
+  // Apple proprietary PCST (Podcast)
+  { { 'P', 'C', 'S', 'T' }, &create<PodcastFrame> },
   // ID3v2.2 Attached Picture
-
-  if(frameID == "PIC") {
-    AttachedPictureFrame *f = new AttachedPictureFrameV22(data, header);
-    d->setTextEncoding(f);
-    return f;
-  }
-
+  { { 'P', 'I', 'C', 0   }, &createWithEncoding<AttachedPictureFrameV22> },
+  // Popularimeter (frames 4.17)
+  { { 'P', 'O', 'P', 'M' }, &create<PopularimeterFrame> },
+  // Private (frames 4.27)
+  { { 'P', 'R', 'I', 'V' }, &create<PrivateFrame> },
   // Relative Volume Adjustment (frames 4.11)
-
-  if(frameID == "RVA2")
-    return new RelativeVolumeFrame(data, header);
-
+  { { 'R', 'V', 'A', '2' }, &create<RelativeVolumeFrame> },
+  // Synchronized lyrics/text (frames 4.9)
+  { { 'S', 'Y', 'L', 'T' }, &createWithEncoding<SynchronizedLyricsFrame> },
+  // Content type (frames 4.2.3)
+  { { 'T', 'C', 'O', 'N' }, &createGenre },
+  // User defined text (frames 4.2.6)
+  { { 'T', 'X', 'X', 'X' }, &createWithEncoding<UserTextIdentificationFrame> },
   // Unique File Identifier (frames 4.1)
-
-  if(frameID == "UFID")
-    return new UniqueFileIdentifierFrame(data, header);
-
-  // General Encapsulated Object (frames 4.15)
-
-  if(frameID == "GEOB") {
-    GeneralEncapsulatedObjectFrame *f = new GeneralEncapsulatedObjectFrame(data, header);
-    d->setTextEncoding(f);
-    return f;
-  }
-
-  // URL link (frames 4.3)
-
-  if(frameID.startsWith("W")) {
-    if(frameID != "WXXX") {
-      return new UrlLinkFrame(data, header);
-    }
-    UserUrlLinkFrame *f = new UserUrlLinkFrame(data, header);
-    d->setTextEncoding(f);
-    return f;
-  }
-
+  { { 'U', 'F', 'I', 'D' }, &create<UniqueFileIdentifierFrame> },
   // Unsynchronized lyric/text transcription (frames 4.8)
+  { { 'U', 'S', 'L', 'T' }, &createWithEncoding<UnsynchronizedLyricsFrame> },
+  // Apple proprietary WFED (Podcast URL), a text frame
+  { { 'W', 'F', 'E', 'D' }, &createWithEncoding<TextIdentificationFrame> },
+  // User defined URL link (frames 4.3.2)
+  { { 'W', 'X', 'X', 'X' }, &createWithEncoding<UserUrlLinkFrame> },
+};
 
-  if(frameID == "USLT") {
-    UnsynchronizedLyricsFrame *f = new UnsynchronizedLyricsFrame(data, header);
-    if(d->useDefaultEncoding)
-      f->setTextEncoding(d->defaultEncoding);
-    return f;
-  }
-
-  // Synchronized lyrics/text (frames 4.9)
-
-  if(frameID == "SYLT") {
-    SynchronizedLyricsFrame *f = new SynchronizedLyricsFrame(data, header);
-    if(d->useDefaultEncoding)
-      f->setTextEncoding(d->defaultEncoding);
-    return f;
-  }
-
-  // Event timing codes (frames 4.5)
-
-  if(frameID == "ETCO")
-    return new EventTimingCodesFrame(data, header);
-
-  // Popularimeter (frames 4.17)
-
-  if(frameID == "POPM")
-    return new PopularimeterFrame(data, header);
-
-  // Private (frames 4.27)
-
-  if(frameID == "PRIV")
-    return new PrivateFrame(data, header);
-
-  // Ownership (frames 4.22)
+const FrameFactory::FrameFactoryPrivate::FrameType *const
+FrameFactory::FrameFactoryPrivate::frameTypesEnd =
+  frameTypes + sizeof(frameTypes) / sizeof(frameTypes[0]);
 
-  if(frameID == "OWNE") {
-    OwnershipFrame *f = new OwnershipFrame(data, header);
-    d->setTextEncoding(f);
-    return f;
-  }
+FrameFactory FrameFactory::factory;
 
-  // Chapter (ID3v2 chapters 1.0)
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
 
-  if(frameID == "CHAP")
-    return new ChapterFrame(tagHeader, data, header);
+FrameFactory *FrameFactory::instance()
+{
+  return &factory;
+}
 
-  // Table of contents (ID3v2 chapters 1.0)
+Frame *FrameFactory::createFrame(const ByteVector &data, bool synchSafeInts) const
+{
+  return createFrame(data, static_cast<unsigned int>(synchSafeInts ? 4 : 3));
+}
 
-  if(frameID == "CTOC")
-    return new TableOfContentsFrame(tagHeader, data, header);
+Frame *FrameFactory::createFrame(const ByteVector &data, unsigned int version) const
+{
+  Header tagHeader;
+  tagHeader.setMajorVersion(version);
+  return createFrame(data, &tagHeader);
+}
 
-  // Apple proprietary PCST (Podcast)
+Frame *FrameFactory::createFrame(const ByteVector &origData, Header *tagHeader) const
+{
+    return createFrame(origData, const_cast<const Header *>(tagHeader));
+}
 
-  if(frameID == "PCST")
-    return new PodcastFrame(data, header);
+Frame *FrameFactory::createFrame(const ByteVector &origData, const Header *tagHeader) const
+{
+  Frame::Header *header = parseFrameHeader(origData, tagHeader);
+  if(!header)
+    return 0;
 
-  return new UnknownFrame(data, header);
+  return createFrame(origData, header, tagHeader, false);
 }
 
 void FrameFactory::rebuildAggregateFrames(ID3v2::Tag *tag) const
@@ -390,92 +321,144 @@ FrameFactory::~FrameFactory()
   delete d;
 }
 
+void FrameFactory::registerFrameType(const ByteVector &frameID, FrameCreator creator)
+{
+  if(creator)
+    d->customFrameTypes[frameID] = creator;
+  else
+    d->customFrameTypes.erase(frameID);
+}
+
 namespace
 {
+  // Frame conversion tables, sorted by the old frame ID.  Frames which have no
+  // ID3v2.4 equivalent are mapped to 0 and discarded.
+
+  struct FrameConversion
+  {
+    const char *oldID;
+    const char *newID;
+  };
+
   // Frame conversion table ID3v2.2 -> 2.4
-  const std::pair<const char *, const char *> frameConversion2[] = {
-    std::make_pair("BUF", "RBUF"),
-    std::make_pair("CNT", "PCNT"),
-    std::make_pair("COM", "COMM"),
-    std::make_pair("CRA", "AENC"),
-    std::make_pair("ETC", "ETCO"),
-    std::make_pair("GEO", "GEOB"),
-    std::make_pair("IPL", "TIPL"),
-    std::make_pair("MCI", "MCDI"),
-    std::make_pair("MLL", "MLLT"),
-    std::make_pair("POP", "POPM"),
-    std::make_pair("REV", "RVRB"),
-    std::make_pair("SLT", "SYLT"),
-    std::make_pair("STC", "SYTC"),
-    std::make_pair("TAL", "TALB"),
-    std::make_pair("TBP", "TBPM"),
-    std::make_pair("TCM", "TCOM"),
-    std::make_pair("TCO", "TCON"),
-    std::make_pair("TCP", "TCMP"),
-    std::make_pair("TCR", "TCOP"),
-    std::make_pair("TDY", "TDLY"),
-    std::make_pair("TEN", "TENC"),
-    std::make_pair("TFT", "TFLT"),
-    std::make_pair("TKE", "TKEY"),
-    std::make_pair("TLA", "TLAN"),
-    std::make_pair("TLE", "TLEN"),
-    std::make_pair("TMT", "TMED"),
-    std::make_pair("TOA", "TOAL"),
-    std::make_pair("TOF", "TOFN"),
-    std::make_pair("TOL", "TOLY"),
-    std::make_pair("TOR", "TDOR"),
-    std::make_pair("TOT", "TOAL"),
-    std::make_pair("TP1", "TPE1"),
-    std::make_pair("TP2", "TPE2"),
-    std::make_pair("TP3", "TPE3"),
-    std::make_pair("TP4", "TPE4"),
-    std::make_pair("TPA", "TPOS"),
-    std::make_pair("TPB", "TPUB"),
-    std::make_pair("TRC", "TSRC"),
-    std::make_pair("TRD", "TDRC"),
-    std::make_pair("TRK", "TRCK"),
-    std::make_pair("TS2", "TSO2"),
-    std::make_pair("TSA", "TSOA"),
-    std::make_pair("TSC", "TSOC"),
-    std::make_pair("TSP", "TSOP"),
-    std::make_pair("TSS", "TSSE"),
-    std::make_pair("TST", "TSOT"),
-    std::make_pair("TT1", "TIT1"),
-    std::make_pair("TT2", "TIT2"),
-    std::make_pair("TT3", "TIT3"),
-    std::make_pair("TXT", "TOLY"),
-    std::make_pair("TXX", "TXXX"),
-    std::make_pair("TYE", "TDRC"),
-    std::make_pair("UFI", "UFID"),
-    std::make_pair("ULT", "USLT"),
-    std::make_pair("WAF", "WOAF"),
-    std::make_pair("WAR", "WOAR"),
-    std::make_pair("WAS", "WOAS"),
-    std::make_pair("WCM", "WCOM"),
-    std::make_pair("WCP", "WCOP"),
-    std::make_pair("WPB", "WPUB"),
-    std::make_pair("WXX", "WXXX"),
-
-    // Apple iTunes nonstandard frames
-    std::make_pair("PCS", "PCST"),
-    std::make_pair("TCT", "TCAT"),
-    std::make_pair("TDR", "TDRL"),
-    std::make_pair("TDS", "TDES"),
-    std::make_pair("TID", "TGID"),
-    std::make_pair("WFD", "WFED"),
-    std::make_pair("MVN", "MVNM"),
-    std::make_pair("MVI", "MVIN"),
-    std::make_pair("GP1", "GRP1"),
+  const FrameConversion frameConversion2[] = {
+    { "BUF", "RBUF" },
+    { "CNT", "PCNT" },
+    { "COM", "COMM" },
+    { "CRA", "AENC" },
+    { "CRM", 0      }, // discarded
+    { "EQU", 0      }, // discarded
+    { "ETC", "ETCO" },
+    { "GEO", "GEOB" },
+    { "GP1", "GRP1" }, // iTunes
+    { "IPL", "TIPL" },
+    { "LNK", 0      }, // discarded
+    { "MCI", "MCDI" },
+    { "MLL", "MLLT" },
+    { "MVI", "MVIN" }, // iTunes
+    { "MVN", "MVNM" }, // iTunes
+    { "PCS", "PCST" }, // iTunes
+    { "POP", "POPM" },
+    { "REV", "RVRB" },
+    { "RVA", 0      }, // discarded
+    { "SLT", "SYLT" },
+    { "STC", "SYTC" },
+    { "TAL", "TALB" },
+    { "TBP", "TBPM" },
+    { "TCM", "TCOM" },
+    { "TCO", "TCON" },
+    { "TCP", "TCMP" },
+    { "TCR", "TCOP" },
+    { "TCT", "TCAT" }, // iTunes
+    { "TDA", 0      }, // discarded
+    { "TDR", "TDRL" }, // iTunes
+    { "TDS", "TDES" }, // iTunes
+    { "TDY", "TDLY" },
+    { "TEN", "TENC" },
+    { "TFT", "TFLT" },
+    { "TID", "TGID" }, // iTunes
+    { "TIM", 0      }, // discarded
+    { "TKE", "TKEY" },
+    { "TLA", "TLAN" },
+    { "TLE", "TLEN" },
+    { "TMT", "TMED" },
+    { "TOA", "TOAL" },
+    { "TOF", "TOFN" },
+    { "TOL", "TOLY" },
+    { "TOR", "TDOR" },
+    { "TOT", "TOAL" },
+    { "TP1", "TPE1" },
+    { "TP2", "TPE2" },
+    { "TP3", "TPE3" },
+    { "TP4", "TPE4" },
+    { "TPA", "TPOS" },
+    { "TPB", "TPUB" },
+    { "TRC", "TSRC" },
+    { "TRD", "TDRC" },
+    { "TRK", "TRCK" },
+    { "TS2", "TSO2" },
+    { "TSA", "TSOA" },
+    { "TSC", "TSOC" },
+    { "TSI", 0      }, // discarded
+    { "TSP", "TSOP" },
+    { "TSS", "TSSE" },
+    { "TST", "TSOT" },
+    { "TT1", "TIT1" },
+    { "TT2", "TIT2" },
+    { "TT3", "TIT3" },
+    { "TXT", "TOLY" },
+    { "TXX", "TXXX" },
+    { "TYE", "TDRC" },
+    { "UFI", "UFID" },
+    { "ULT", "USLT" },
+    { "WAF", "WOAF" },
+    { "WAR", "WOAR" },
+    { "WAS", "WOAS" },
+    { "WCM", "WCOM" },
+    { "WCP", "WCOP" },
+    { "WFD", "WFED" }, // iTunes
+    { "WPB", "WPUB" },
+    { "WXX", "WXXX" },
   };
-  const size_t frameConversion2Size = sizeof(frameConversion2) / sizeof(frameConversion2[0]);
 
   // Frame conversion table ID3v2.3 -> 2.4
-  const std::pair<const char *, const char *> frameConversion3[] = {
-    std::make_pair("TORY", "TDOR"),
-    std::make_pair("TYER", "TDRC"),
-    std::make_pair("IPLS", "TIPL"),
+  const FrameConversion frameConversion3[] = {
+    { "EQUA", 0      }, // discarded
+    { "IPLS", "TIPL" },
+    { "RVAD", 0      }, // discarded
+    { "TDAT", 0      }, // discarded
+    { "TIME", 0      }, // discarded
+    { "TORY", "TDOR" },
+    { "TRDA", 0      }, // discarded
+    { "TSIZ", 0      }, // discarded
+    { "TYER", "TDRC" },
   };
-  const size_t frameConversion3Size = sizeof(frameConversion3) / sizeof(frameConversion3[0]);
+
+  int compareFrameID(const char *id, const ByteVector &frameID)
+  {
+    const size_t length = ::strlen(id);
+    const int cmp = ::memcmp(id, frameID.data(), std::min<size_t>(length, frameID.size()));
+    if(cmp != 0)
+      return cmp;
+
+    return static_cast<int>(length) - static_cast<int>(frameID.size());
+  }
+
+  bool conversionLess(const FrameConversion &conversion, const ByteVector &frameID)
+  {
+    return compareFrameID(conversion.oldID, frameID) < 0;
+  }
+
+  template <size_t N>
+  const FrameConversion *findConversion(const FrameConversion (&table)[N],
+                                        const ByteVector &frameID)
+  {
+    const FrameConversion *it = std::lower_bound(table, table + N, frameID, conversionLess);
+    if(it != table + N && compareFrameID(it->oldID, frameID) == 0)
+      return it;
+
+    return 0;
+  }
 }  // namespace
 
 bool FrameFactory::updateFrame(Frame::Header *header) const
@@ -485,52 +468,24 @@ bool FrameFactory::updateFrame(Frame::Header *header) const
   switch(header->version()) {
 
   case 2: // ID3v2.2
+  case 3: // ID3v2.3
   {
-    if(frameID == "CRM" ||
-       frameID == "EQU" ||
-       frameID == "LNK" ||
-       frameID == "RVA" ||
-       frameID == "TIM" ||
-       frameID == "TSI" ||
-       frameID == "TDA")
-    {
-      debug("ID3v2.4 no longer supports the frame type " + String(frameID) +
-            ".  It will be discarded from the tag.");
-      return false;
-    }
-
     // ID3v2.2 only used 3 bytes for the frame ID, so we need to convert all of
-    // the frames to their 4 byte ID3v2.4 equivalent.
-
-    for(size_t i = 0; i < frameConversion2Size; ++i) {
-      if(frameID == frameConversion2[i].first) {
-        header->setFrameID(frameConversion2[i].second);
-        break;
+    // the frames to their 4 byte ID3v2.4 equivalent.  Some ID3v2.3 frames have
+    // been renamed or dropped in ID3v2.4, too.
+
+    const FrameConversion *conversion = header->version() == 2
+      ? findConversion(frameConversion2, frameID)
+      : findConversion(frameConversion3, frameID);
+
+    if(conversion) {
+      if(!conversion->newID) {
+        debug("ID3v2.4 no longer supports the frame type " + String(frameID) +
+              ".  It will be discarded from the tag.");
+        return false;
       }
-    }
-
-    break;
-  }
-
-  case 3: // ID3v2.3
-  {
-    if(frameID == "EQUA" ||
-       frameID == "RVAD" ||
-       frameID == "TIME" ||
-       frameID == "TRDA" ||
-       frameID == "TSIZ" ||
-       frameID == "TDAT")
-    {
-      debug("ID3v2.4 no longer supports the frame type " + String(frameID) +
-            ".  It will be discarded from the tag.");
-      return false;
-    }
 
-    for(size_t i = 0; i < frameConversion3Size; ++i) {
-      if(frameID == frameConversion3[i].first) {
-        header->setFrameID(frameConversion3[i].second);
-        break;
-      }
+      header->setFrameID(conversion->newID);
     }
 
     break;
@@ -549,3 +504,127 @@ bool FrameFactory::updateFrame(Frame::Header *header) const
 
   return true;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+Frame::Header *FrameFactory::parseFrameHeader(const ByteVector &data, const Header *tagHeader) const
+{
+  unsigned int version = tagHeader->majorVersion();
+  Frame::Header *header = new Frame::Header(data, version);
+  ByteVector frameID = header->frameID();
+
+  // A quick sanity check -- make sure that the frameID is 4 uppercase Latin1
+  // characters.  Also make sure that there is data in the frame.
+
+  if(frameID.size() != (version < 3 ? 3 : 4) ||
+     header->frameSize() <= static_cast<unsigned int>(header->dataLengthIndicator() ? 4 : 0) ||
+     header->frameSize() > data.size())
+  {
+    delete header;
+    return 0;
+  }
+
+#ifndef NO_ITUNES_HACKS
+  if(version == 3 && frameID.size() == 4 && frameID.at(3) == '\0') {
+    // iTunes v2.3 tags store v2.2 frames - convert now
+    frameID = frameID.mid(0, 3);
+    header->setFrameID(frameID);
+    header->setVersion(2);
+    updateFrame(header);
+    header->setVersion(3);
+  }
+#endif
+
+  // Use at() so that the frame ID, which shares the tag data, is not detached.
+
+  for(unsigned int i = 0; i < frameID.size(); ++i) {
+    const char c = frameID.at(i);
+    if( (c < 'A' || c > 'Z') && (c < '0' || c > '9') ) {
+      delete header;
+      return 0;
+    }
+  }
+
+  return header;
+}
+
+Frame *FrameFactory::createFrame(const ByteVector &origData, Frame::Header *header,
+                                 const Header *tagHeader, bool updated) const
+{
+  ByteVector data = origData;
+  const unsigned int version = tagHeader->majorVersion();
+
+  if(version > 3 && (tagHeader->unsynchronisation() || header->unsynchronisation())) {
+    // Data lengths are not part of the encoded data, but since they are synch-safe
+    // integers they will be never actually encoded.
+    const unsigned int headerSize = Frame::Header::size(version);
+
+    bool headerHasFF = false;
+    for(unsigned int i = 0; i < headerSize && !headerHasFF; ++i)
+      headerHasFF = data.at(i) == '\xff';
+
+    if(!headerHasFF) {
+      // A frame header without any 0xFF byte is not affected by decoding, so
+      // decode the whole frame in a single pass.
+      data = SynchData::decode(data.mid(0, headerSize + header->frameSize()));
+    }
+    else {
+      ByteVector frameData = data.mid(headerSize, header->frameSize());
+      frameData = SynchData::decode(frameData);
+      data = data.mid(0, headerSize) + frameData;
+    }
+  }
+
+  // TagLib doesn't mess with encrypted frames, so just treat them
+  // as unknown frames.
+
+  if(!zlib::isAvailable() && header->compression()) {
+    debug("Compressed frames are currently not supported.");
+    return new UnknownFrame(data, header);
+  }
+
+  if(header->encryption()) {
+    debug("Encrypted frames are currently not supported.");
+    return new UnknownFrame(data, header);
+  }
+
+  if(!updated && !updateFrame(header)) {
+    header->setTagAlterPreservation(true);
+    return new UnknownFrame(data, header);
+  }
+
+  // updateFrame() might have updated the frame ID.
+
+  const ByteVector frameID = header->frameID();
+
+  // Frame types registered by a subclass take precedence over the built-in
+  // ones.
+
+  if(!d->customFrameTypes.isEmpty()) {
+    Map<ByteVector, FrameCreator>::ConstIterator it = d->customFrameTypes.find(frameID);
+    if(it != d->customFrameTypes.end())
+      return it->second(data, header, tagHeader);
+  }
+
+  if(const FrameFactoryPrivate::FrameType *type = FrameFactoryPrivate::findFrameType(frameID))
+    return type->create(d, data, header, tagHeader);
+
+  // Text Identification (frames 4.2)
+
+  if(frameID.at(0) == 'T')
+    return FrameFactoryPrivate::createWithEncoding<TextIdentificationFrame>(d, data, header, tagHeader);
+
+  // URL link (frames 4.3)
+
+  if(frameID.at(0) == 'W')
+    return new UrlLinkFrame(data, header);
+
+  return new UnknownFrame(data, header);
+}
+
+bool FrameFactory::hasDefaultTextEncoding() const
+{
+  return d->useDefaultEncoding;
+}
@@ -46,10 +46,10 @@ namespace TagLib {
      *
      * Reimplementing this factory is the key to adding support for frame types
      * not directly supported by TagLib to your application.  To do so you would
-     * subclass this factory and reimplement createFrame().  Then by setting your
-     * factory to be the default factory in ID3v2::Tag constructor you can
-     * implement behavior that will allow for new ID3v2::Frame subclasses (also
-     * provided by you) to be used.
+     * subclass this factory and register your frame types with
+     * registerFrameType().  Then by setting your factory to be the default
+     * factory in ID3v2::Tag constructor you can implement behavior that will
+     * allow for new ID3v2::Frame subclasses (also provided by you) to be used.
      *
      * This implements both <i>abstract factory</i> and <i>singleton</i> patterns
      * of which more information is available on the web and in software design
@@ -153,10 +153,57 @@ namespace TagLib {
        */
       virtual bool updateFrame(Frame::Header *header) const;
 
+      /*!
+       * A function which creates a frame from \a data.  The frame header has
+       * already been parsed into \a header, which is owned by the new frame.
+       * \a tagHeader is the header of the tag which is being read.
+       *
+       * Since Frame::Header is only accessible to frames, this is usually a
+       * static member function of the frame class.
+       *
+       * \see registerFrameType()
+       */
+      typedef Frame *(*FrameCreator)(const ByteVector &data, Frame::Header *header,
+                                     const Header *tagHeader);
+
+      /*!
+       * Makes createFrame() use \a creator for frames with the ID \a frameID
+       * instead of the built-in frame type.  Since this is done after
+       * updateFrame(), \a frameID should be an ID3v2.4 frame ID.  Passing a
+       * null \a creator restores the built-in frame type.
+       *
+       * This is meant to be called by subclasses, usually in their constructor.
+       */
+      void registerFrameType(const ByteVector &frameID, FrameCreator creator);
+
     private:
+      friend class Tag;
+
       FrameFactory(const FrameFactory &);
       FrameFactory &operator=(const FrameFactory &);
 
+      /*!
+       * Parses the header of the frame at the start of \a data and checks that
+       * it describes a valid frame.  Returns 0 if it does not.  This is the
+       * first step of createFrame(), which ID3v2::Tag also uses to index the
+       * frames of a tag without creating them.
+       */
+      Frame::Header *parseFrameHeader(const ByteVector &data, const Header *tagHeader) const;
+
+      /*!
+       * Creates a frame from \a data, the header of which has already been
+       * parsed into \a header by parseFrameHeader().  If \a updated is true,
+       * \a header has also been passed to updateFrame() already.
+       */
+      Frame *createFrame(const ByteVector &data, Frame::Header *header,
+                         const Header *tagHeader, bool updated) const;
+
+      /*!
+       * Returns true if a default text encoding has been set, which the text
+       * frames are converted to when they are created.
+       */
+      bool hasDefaultTextEncoding() const;
+
       static FrameFactory factory;
 
       class FrameFactoryPrivate;
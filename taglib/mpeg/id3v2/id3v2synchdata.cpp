@@ -23,6 +23,8 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "id3v2synchdata.h"
@@ -72,6 +74,26 @@ ByteVector SynchData::fromUInt(unsigned int value)
   return v;
 }
 
+namespace
+{
+  // Returns the position of the first "\xff\x00" sequence in [begin, end),
+  // or 0 if there is none.
+
+  const char *findFalseSync(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    while(p < end - 1) {
+      p = static_cast<const char *>(::memchr(p, '\xff', end - 1 - p));
+      if(!p)
+        return 0;
+      if(p[1] == '\x00')
+        return p;
+      ++p;
+    }
+    return 0;
+  }
+}  // namespace
+
 ByteVector SynchData::decode(const ByteVector &data)
 {
   if (data.size() == 0) {
@@ -80,23 +102,30 @@ ByteVector SynchData::decode(const ByteVector &data)
 
   // We have this optimized method instead of using ByteVector::replace(),
   // since it makes a great difference when decoding huge unsynchronized frames.
+  // If there is nothing to decode, the data is shared with the caller instead
+  // of being copied.
 
-  ByteVector result(data.size());
+  const char *const begin = data.data();
+  const char *const end   = begin + data.size();
+
+  const char *sync = findFalseSync(begin, end);
+  if(!sync)
+    return data;
 
-  ByteVector::ConstIterator src = data.begin();
-  ByteVector::Iterator dst = result.begin();
+  ByteVector result(data.size());
 
-  while(src < data.end() - 1) {
-    *dst++ = *src++;
+  const char *src = begin;
+  char *dst = result.data();
 
-    if(*(src - 1) == '\xff' && *src == '\x00')
-      src++;
+  while(sync) {
+    dst = std::copy(src, sync + 1, dst);
+    src = sync + 2;
+    sync = findFalseSync(src, end);
   }
 
-  if(src < data.end())
-    *dst++ = *src++;
+  dst = std::copy(src, end, dst);
 
-  result.resize(static_cast<unsigned int>(dst - result.begin()));
+  result.resize(static_cast<unsigned int>(dst - result.data()));
 
   return result;
 }
@@ -31,6 +31,7 @@
 #include <tdebug.h>
 #include <tfile.h>
 #include <tpicturemap.h>
+#include <tzlib.h>
 
 #include "id3v2tag.h"
 #include "id3v2header.h"
@@ -56,7 +57,6 @@ namespace
   const ID3v2::Latin1StringHandler *stringHandler = &defaultStringHandler;
 
   const long MinPaddingSize = 1024;
-  const long MaxPaddingSize = 1024 * 1024;
 
   bool contains(const char **a, const ByteVector &v)
   {
@@ -67,6 +67,35 @@ namespace
     }
     return false;
   }
+
+  // A frame which has been found while parsing the tag, but has not been
+  // created yet.  Its data is kept so that the frame can be created when it
+  // is accessed, or written back as it is if it never is.
+
+  class PendingFrame : public ID3v2::Frame
+  {
+  public:
+    PendingFrame(const ByteVector &data, Header *h) :
+      Frame(h),
+      frameData(data),
+      created(0) {}
+
+    virtual String toString() const { return String(); }
+
+    Header *releaseHeader()
+    {
+      Header *h = header();
+      setHeader(0, false);
+      return h;
+    }
+
+    const ByteVector frameData;
+    Frame *created;
+
+  protected:
+    virtual void parseFields(const ByteVector &) {}
+    virtual ByteVector renderFields() const { return ByteVector(); }
+  };
 }  // namespace
 
 class ID3v2::Tag::TagPrivate
@@ -77,7 +106,9 @@ public:
     file(0),
     tagOffset(0),
     extendedHeader(0),
-    footer(0)
+    footer(0),
+    hasPendingFrames(false),
+    pendingFramesVerbatim(false)
   {
     frameList.setAutoDelete(true);
   }
@@ -99,8 +130,122 @@ public:
 
   FrameListMap frameListMap;
   FrameList frameList;
+
+  // The header of the tag as it was read, which pending frames are created
+  // with, even if the tag header has been changed since.
+  Header readHeader;
+
+  bool hasPendingFrames;
+  bool pendingFramesVerbatim;
+
+  bool isFrameDeferrable(Frame::Header *header) const;
+  Frame *createFrame(PendingFrame *pending) const;
+  void createPendingFrames(const ByteVector &frameID);
+  void createPendingFrames();
 };
 
+bool ID3v2::Tag::TagPrivate::isFrameDeferrable(Frame::Header *header) const
+{
+  // Frames which FrameFactory::createFrame() would not pass to updateFrame()
+  // or which it would discard are created right away.
+
+  if(header->encryption() || (header->compression() && !zlib::isAvailable()))
+    return false;
+
+  if(header->version() < 4)
+    return factory->updateFrame(header);
+
+  // Frames of an ID3v2.4 tag are written back as they are read, so they must
+  // not need any update.
+
+  const ByteVector frameID = header->frameID();
+  return factory->updateFrame(header) && header->frameID() == frameID;
+}
+
+ID3v2::Frame *ID3v2::Tag::TagPrivate::createFrame(PendingFrame *pending) const
+{
+  // The header has been checked and updated when the tag was parsed.
+
+  return factory->createFrame(pending->frameData, pending->releaseHeader(), &readHeader, true);
+}
+
+void ID3v2::Tag::TagPrivate::createPendingFrames(const ByteVector &frameID)
+{
+  if(!hasPendingFrames)
+    return;
+
+  FrameListMap::Iterator mapIt = frameListMap.find(frameID);
+  if(mapIt == frameListMap.end())
+    return;
+
+  FrameList &frames = mapIt->second;
+  for(FrameList::Iterator it = frames.begin(); it != frames.end();) {
+    PendingFrame *pending = dynamic_cast<PendingFrame *>(*it);
+    if(!pending) {
+      ++it;
+      continue;
+    }
+
+    Frame *frame = createFrame(pending);
+    FrameList::Iterator listIt = frameList.find(pending);
+    if(frame) {
+      *listIt = frame;
+      *it = frame;
+      ++it;
+    }
+    else {
+      frameList.erase(listIt);
+      it = frames.erase(it);
+    }
+    delete pending;
+  }
+}
+
+void ID3v2::Tag::TagPrivate::createPendingFrames()
+{
+  if(!hasPendingFrames)
+    return;
+
+  hasPendingFrames = false;
+
+  for(FrameListMap::Iterator mapIt = frameListMap.begin(); mapIt != frameListMap.end(); ++mapIt) {
+    FrameList &frames = mapIt->second;
+    for(FrameList::Iterator it = frames.begin(); it != frames.end();) {
+      PendingFrame *pending = dynamic_cast<PendingFrame *>(*it);
+      if(!pending) {
+        ++it;
+        continue;
+      }
+
+      pending->created = createFrame(pending);
+      if(pending->created) {
+        *it = pending->created;
+        ++it;
+      }
+      else {
+        it = frames.erase(it);
+      }
+    }
+  }
+
+  for(FrameList::Iterator it = frameList.begin(); it != frameList.end();) {
+    PendingFrame *pending = dynamic_cast<PendingFrame *>(*it);
+    if(!pending) {
+      ++it;
+      continue;
+    }
+
+    if(pending->created) {
+      *it = pending->created;
+      ++it;
+    }
+    else {
+      it = frameList.erase(it);
+    }
+    delete pending;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // StringHandler implementation
 ////////////////////////////////////////////////////////////////////////////////
@@ -145,28 +290,28 @@ ID3v2::Tag::~Tag()
 
 String ID3v2::Tag::title() const
 {
-  if(!d->frameListMap["TIT2"].isEmpty())
-    return d->frameListMap["TIT2"].front()->toString();
+  if(!frameList("TIT2").isEmpty())
+    return frameList("TIT2").front()->toString();
   return String();
 }
 
 String ID3v2::Tag::artist() const
 {
-  if(!d->frameListMap["TPE1"].isEmpty())
-    return d->frameListMap["TPE1"].front()->toString();
+  if(!frameList("TPE1").isEmpty())
+    return frameList("TPE1").front()->toString();
   return String();
 }
 
 String ID3v2::Tag::album() const
 {
-  if(!d->frameListMap["TALB"].isEmpty())
-    return d->frameListMap["TALB"].front()->toString();
+  if(!frameList("TALB").isEmpty())
+    return frameList("TALB").front()->toString();
   return String();
 }
 
 String ID3v2::Tag::comment() const
 {
-  const FrameList &comments = d->frameListMap["COMM"];
+  const FrameList &comments = frameList("COMM");
 
   if(comments.isEmpty())
     return String();
@@ -188,7 +333,7 @@ String ID3v2::Tag::genre() const
   // should be separated by " / " instead of " ".  For the moment to keep
   // the behavior the same as released versions it is being left with " ".
 
-  const FrameList &tconFrames = d->frameListMap["TCON"];
+  const FrameList &tconFrames = frameList("TCON");
   TextIdentificationFrame *f;
   if(tconFrames.isEmpty() ||
      !(f = dynamic_cast<TextIdentificationFrame *>(tconFrames.front())))
@@ -226,15 +371,15 @@ String ID3v2::Tag::genre() const
 
 unsigned int ID3v2::Tag::year() const
 {
-  if(!d->frameListMap["TDRC"].isEmpty())
-    return d->frameListMap["TDRC"].front()->toString().substr(0, 4).toInt();
+  if(!frameList("TDRC").isEmpty())
+    return frameList("TDRC").front()->toString().substr(0, 4).toInt();
   return 0;
 }
 
 unsigned int ID3v2::Tag::track() const
 {
-  if(!d->frameListMap["TRCK"].isEmpty())
-    return d->frameListMap["TRCK"].front()->toString().toInt();
+  if(!frameList("TRCK").isEmpty())
+    return frameList("TRCK").front()->toString().toInt();
   return 0;
 }
 
@@ -244,7 +389,7 @@ TagLib::PictureMap ID3v2::Tag::pictures() const
     return PictureMap();
 
   PictureMap map;
-  FrameList frameListMap = d->frameListMap["APIC"];
+  FrameList frameListMap = frameList("APIC");
   for(FrameList::ConstIterator it = frameListMap.begin();
       it != frameListMap.end();
       ++it) {
@@ -346,7 +491,7 @@ void ID3v2::Tag::setComment(const String &s)
     return;
   }
 
-  const FrameList &comments = d->frameListMap["COMM"];
+  const FrameList &comments = frameList("COMM");
 
   if(!comments.isEmpty()) {
     for(FrameList::ConstIterator it = comments.begin(); it != comments.end(); ++it) {
@@ -523,16 +668,19 @@ Footer *ID3v2::Tag::footer() const
 
 const FrameListMap &ID3v2::Tag::frameListMap() const
 {
+  d->createPendingFrames();
   return d->frameListMap;
 }
 
 const FrameList &ID3v2::Tag::frameList() const
 {
+  d->createPendingFrames();
   return d->frameList;
 }
 
 const FrameList &ID3v2::Tag::frameList(const ByteVector &frameID) const
 {
+  d->createPendingFrames(frameID);
   return d->frameListMap[frameID];
 }
 
@@ -806,6 +954,11 @@ ByteVector ID3v2::Tag::render(int version) const
 }
 
 ByteVector ID3v2::Tag::render(Version version) const
+{
+  return render(version, d->file);
+}
+
+ByteVector ID3v2::Tag::render(Version version, const File *file) const
 {
   // We need to render the "tag data" first so that we have to correct size to
   // render in the tag's header.  The "tag data" -- everything that is included
@@ -816,6 +969,13 @@ ByteVector ID3v2::Tag::render(Version version) const
 
   // Downgrade the frames that ID3v2.3 doesn't support.
 
+  // Frames which have not been accessed are written back as they were read if
+  // possible, otherwise they have to be created now.  This includes the case
+  // of a default text encoding, which all frames are converted to.
+
+  if(version != v4 || !d->pendingFramesVerbatim || d->factory->hasDefaultTextEncoding())
+    d->createPendingFrames();
+
   FrameList newFrames;
   newFrames.setAutoDelete(true);
 
@@ -841,7 +1001,8 @@ ByteVector ID3v2::Tag::render(Version version) const
       continue;
     }
     if(!(*it)->header()->tagAlterPreservation()) {
-      const ByteVector frameData = (*it)->render();
+      const PendingFrame *pending = dynamic_cast<const PendingFrame *>(*it);
+      const ByteVector frameData = pending ? pending->frameData : (*it)->render();
       if(frameData.size() == Frame::headerSize((*it)->header()->version())) {
         debug("An empty ID3v2 frame \'"
           + String((*it)->header()->frameID()) + "\' has been discarded");
@@ -853,20 +1014,19 @@ ByteVector ID3v2::Tag::render(Version version) const
 
   // Compute the amount of padding, and append that to tagData.
 
-  long originalSize = d->header.tagSize();
-  long paddingSize = originalSize - (tagData.size() - Header::size());
+  const long originalSize = d->header.tagSize();
+  const long framesSize = tagData.size() - Header::size();
+  long paddingSize;
 
-  if(paddingSize <= 0) {
-    paddingSize = MinPaddingSize;
+  if(file) {
+    paddingSize = file->paddingSize(originalSize, framesSize, MinPaddingSize);
   }
   else {
-    // Padding won't increase beyond 1% of the file size or 1MB.
+    paddingSize = originalSize - framesSize;
 
-    long threshold = d->file ? d->file->length() / 100 : 0;
-    threshold = std::max(threshold, MinPaddingSize);
-    threshold = std::min(threshold, MaxPaddingSize);
+    // Padding won't increase beyond 1KB without a file.
 
-    if(paddingSize > threshold)
+    if(paddingSize <= 0 || paddingSize > MinPaddingSize)
       paddingSize = MinPaddingSize;
   }
 
@@ -909,7 +1069,9 @@ void ID3v2::Tag::read()
     return;
 
   d->file->seek(d->tagOffset);
-  d->header.setData(d->file->readBlock(Header::size()));
+  const ByteVector headerData = d->file->readBlock(Header::size());
+  d->header.setData(headerData);
+  d->readHeader.setData(headerData);
 
   // If the tag size is 0, then this is an invalid tag (tags must contain at
   // least one frame)
@@ -973,6 +1135,8 @@ void ID3v2::Tag::parse(const ByteVector &origData)
 
   // parse frames
 
+  d->pendingFramesVerbatim = d->header.majorVersion() == 4 && !d->header.unsynchronisation();
+
   // Make sure that there is at least enough room in the remaining frame data for
   // a frame header.
 
@@ -989,8 +1153,26 @@ void ID3v2::Tag::parse(const ByteVector &origData)
       break;
     }
 
-    Frame *frame = d->factory->createFrame(data.mid(frameDataPosition),
-                                           &d->header);
+    // Only the headers of the frames are parsed here, the frames themselves
+    // are created when they are accessed.
+
+    const ByteVector frameData = data.mid(frameDataPosition);
+
+    Frame *frame = 0;
+    Frame::Header *header = d->factory->parseFrameHeader(frameData, &d->header);
+
+    if(!header)
+      return;
+
+    if(d->isFrameDeferrable(header)) {
+      const unsigned int frameSize = Frame::headerSize(d->header.majorVersion()) + header->frameSize();
+      frame = new PendingFrame(data.mid(frameDataPosition, frameSize), header);
+      d->hasPendingFrames = true;
+    }
+    else {
+      delete header;
+      frame = d->factory->createFrame(frameData, &d->header);
+    }
 
     if(!frame)
       return;
@@ -1016,8 +1198,8 @@ void ID3v2::Tag::setTextFrame(const ByteVector &id, const String &value)
     return;
   }
 
-  if(!d->frameListMap[id].isEmpty())
-    d->frameListMap[id].front()->setText(value);
+  if(!frameList(id).isEmpty())
+    frameList(id).front()->setText(value);
   else {
     const String::Type encoding = d->factory->defaultTextEncoding();
     TextIdentificationFrame *f = new TextIdentificationFrame(id, encoding);
@@ -254,6 +254,12 @@ namespace TagLib {
        * frameListMap()[frameID];
        * \endcode
        *
+       * \note The frames of a tag which has been read from a file are only
+       * created when they are first accessed.  Unlike frameListMap() and
+       * frameList(), this only creates the frames with the id \a frameID.
+       * Frames which are never accessed are written back as they were read
+       * when the tag is saved as ID3v2.4.
+       *
        * \see frameListMap()
        */
       const FrameList &frameList(const ByteVector &frameID) const;
@@ -352,6 +358,14 @@ namespace TagLib {
        */
       ByteVector render(Version version) const;
 
+      /*!
+       * Render the tag back to binary data, suitable to be written to \a file.
+       * The padding of the tag follows the padding policy of \a file.
+       *
+       * \see File::setPaddingPolicy()
+       */
+      ByteVector render(Version version, const File *file) const;
+
       /*!
        * Gets the current string handler that decides how the "Latin-1" data
        * will be converted to and from binary data.
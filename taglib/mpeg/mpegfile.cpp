@@ -47,13 +47,15 @@ namespace
 class MPEG::File::FilePrivate
 {
 public:
-  FilePrivate(const ID3v2::FrameFactory *frameFactory = ID3v2::FrameFactory::instance()) :
+  FilePrivate(const ID3v2::FrameFactory *frameFactory, Properties::ReadStyle style) :
     ID3v2FrameFactory(frameFactory),
     ID3v2Location(-1),
     ID3v2OriginalSize(0),
     APELocation(-1),
     APEOriginalSize(0),
     ID3v1Location(-1),
+    readParts(TagLib::File::ReadAll),
+    readStyle(style),
     properties(0) {}
 
   ~FilePrivate()
@@ -71,6 +73,9 @@ public:
 
   long ID3v1Location;
 
+  TagLib::File::ReadParts readParts;
+  Properties::ReadStyle readStyle;
+
   TagUnion tag;
 
   Properties *properties;
@@ -93,6 +98,34 @@ namespace
     AudioProperties *audioProperties() const { return 0; }
     bool save() { return false; }
   };
+
+  // Returns the length of the MPEG frame at \a offset if it is followed by a
+  // consistent frame header, or 0 otherwise.  \a buffer holds the data of
+  // \a file from \a bufferOffset.  Both headers are decoded from it, and the
+  // file is read only if either of them is not in the buffer.
+
+  int validFrameLength(TagLib::File *file, const ByteVector &buffer, long bufferOffset, long offset)
+  {
+    const long i    = offset - bufferOffset;
+    const long size = static_cast<long>(buffer.size());
+
+    if(i >= 0 && i + 4 <= size) {
+      MPEG::FrameHeader header;
+      if(!MPEG::decodeFrameHeader(buffer.data() + i, header))
+        return 0;
+
+      const long next = i + header.frameLength;
+      if(next + 4 <= size) {
+        if(!MPEG::isSameStream(buffer.data() + i, buffer.data() + next))
+          return 0;
+
+        return header.frameLength;
+      }
+    }
+
+    const MPEG::Header header(file, offset, true);
+    return header.isValid() ? header.frameLength() : 0;
+  }
 }  // namespace
 
 bool MPEG::File::isSupported(IOStream *stream)
@@ -114,13 +147,11 @@ bool MPEG::File::isSupported(IOStream *stream)
   const long originalPosition = stream->tell();
   AdapterFile file(stream);
 
+  const char *data = buffer.data();
   for(unsigned int i = 0; i < buffer.size() - 1; ++i) {
-    if(isFrameSync(buffer, i)) {
-      const Header header(&file, headerOffset + i, true);
-      if(header.isValid()) {
-        stream->seek(originalPosition);
-        return true;
-      }
+    if(isFrameSync(data + i) && validFrameLength(&file, buffer, headerOffset, headerOffset + i) > 0) {
+      stream->seek(originalPosition);
+      return true;
     }
   }
 
@@ -132,30 +163,48 @@ bool MPEG::File::isSupported(IOStream *stream)
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
-MPEG::File::File(FileName file, bool readProperties, Properties::ReadStyle) :
+MPEG::File::File(FileName file, bool readProperties, Properties::ReadStyle propertiesStyle) :
+  TagLib::File(file),
+  d(new FilePrivate(ID3v2::FrameFactory::instance(), propertiesStyle))
+{
+  if(isOpen())
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
+}
+
+MPEG::File::File(FileName file, ID3v2::FrameFactory *frameFactory,
+                 bool readProperties, Properties::ReadStyle propertiesStyle) :
   TagLib::File(file),
-  d(new FilePrivate())
+  d(new FilePrivate(frameFactory, propertiesStyle))
+{
+  if(isOpen())
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
+}
+
+MPEG::File::File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
+                 bool readProperties, Properties::ReadStyle propertiesStyle) :
+  TagLib::File(stream),
+  d(new FilePrivate(frameFactory, propertiesStyle))
 {
   if(isOpen())
-    read(readProperties);
+    read(readProperties ? ReadAll : ReadTags | ReadPictures);
 }
 
 MPEG::File::File(FileName file, ID3v2::FrameFactory *frameFactory,
-                 bool readProperties, Properties::ReadStyle) :
+                 ReadParts parts, Properties::ReadStyle propertiesStyle) :
   TagLib::File(file),
-  d(new FilePrivate(frameFactory))
+  d(new FilePrivate(frameFactory, propertiesStyle))
 {
   if(isOpen())
-    read(readProperties);
+    read(parts);
 }
 
 MPEG::File::File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
-                 bool readProperties, Properties::ReadStyle) :
+                 ReadParts parts, Properties::ReadStyle propertiesStyle) :
   TagLib::File(stream),
-  d(new FilePrivate(frameFactory))
+  d(new FilePrivate(frameFactory, propertiesStyle))
 {
   if(isOpen())
-    read(readProperties);
+    read(parts);
 }
 
 MPEG::File::~File()
@@ -230,6 +279,11 @@ bool MPEG::File::save(int tags, StripTags strip, ID3v2::Version version, Duplica
     return false;
   }
 
+  if(!(d->readParts & ReadTags)) {
+    debug("MPEG::File::save() -- The tags have not been read.");
+    return false;
+  }
+
   // Create the tags if we've been asked to.
 
   if(duplicate == Duplicate) {
@@ -258,7 +312,7 @@ bool MPEG::File::save(int tags, StripTags strip, ID3v2::Version version, Duplica
       if(d->ID3v2Location < 0)
         d->ID3v2Location = 0;
 
-      const ByteVector data = ID3v2Tag()->render(version);
+      const ByteVector data = ID3v2Tag()->render(version, this);
       insert(data, d->ID3v2Location, d->ID3v2OriginalSize);
 
       if(d->APELocation >= 0)
@@ -408,7 +462,7 @@ void MPEG::File::setID3v2FrameFactory(const ID3v2::FrameFactory *factory)
 
 long MPEG::File::nextFrameOffset(long position)
 {
-  ByteVector frameSyncBytes(2, '\0');
+  char frameSyncBytes[2] = { 0, 0 };
 
   while(true) {
     seek(position);
@@ -416,23 +470,27 @@ long MPEG::File::nextFrameOffset(long position)
     if(buffer.isEmpty())
       return -1;
 
-    for(unsigned int i = 0; i < buffer.size(); ++i) {
-      frameSyncBytes[0] = frameSyncBytes[1];
-      frameSyncBytes[1] = buffer[i];
-      if(isFrameSync(frameSyncBytes)) {
-        const Header header(this, position + i - 1, true);
-        if(header.isValid())
-          return position + i - 1;
-      }
+    const char *data = buffer.data();
+
+    // A frame header may start at the last byte of the previous buffer.
+
+    frameSyncBytes[1] = data[0];
+    if(isFrameSync(frameSyncBytes) && validFrameLength(this, buffer, position, position - 1) > 0)
+      return position - 1;
+
+    for(unsigned int i = 0; i < buffer.size() - 1; ++i) {
+      if(isFrameSync(data + i) && validFrameLength(this, buffer, position, position + i) > 0)
+        return position + i;
     }
 
+    frameSyncBytes[0] = data[buffer.size() - 1];
     position += bufferSize();
   }
 }
 
 long MPEG::File::previousFrameOffset(long position)
 {
-  ByteVector frameSyncBytes(2, '\0');
+  char frameSyncBytes[2] = { 0, 0 };
 
   while(position > 0) {
     const long bufferLength = std::min<long>(position, bufferSize());
@@ -440,16 +498,30 @@ long MPEG::File::previousFrameOffset(long position)
 
     seek(position);
     const ByteVector buffer = readBlock(bufferLength);
+    if(buffer.isEmpty())
+      continue;
+
+    const char *data = buffer.data();
+    const int last = buffer.size() - 1;
+
+    // A frame header may start at the last byte of this buffer.
+
+    frameSyncBytes[0] = data[last];
+    if(isFrameSync(frameSyncBytes)) {
+      const int frameLength = validFrameLength(this, buffer, position, position + last);
+      if(frameLength > 0)
+        return position + last + frameLength;
+    }
 
-    for(int i = buffer.size() - 1; i >= 0; --i) {
-      frameSyncBytes[1] = frameSyncBytes[0];
-      frameSyncBytes[0] = buffer[i];
-      if(isFrameSync(frameSyncBytes)) {
-        const Header header(this, position + i, true);
-        if(header.isValid())
-          return position + i + header.frameLength();
+    for(int i = last - 1; i >= 0; --i) {
+      if(isFrameSync(data + i)) {
+        const int frameLength = validFrameLength(this, buffer, position, position + i);
+        if(frameLength > 0)
+          return position + i + frameLength;
       }
     }
+
+    frameSyncBytes[1] = data[0];
   }
 
   return -1;
@@ -460,7 +532,7 @@ long MPEG::File::firstFrameOffset()
   long position = 0;
 
   if(hasID3v2Tag())
-    position = d->ID3v2Location + ID3v2Tag()->header()->completeTagSize();
+    position = d->ID3v2Location + d->ID3v2OriginalSize;
 
   return nextFrameOffset(position);
 }
@@ -498,22 +570,36 @@ bool MPEG::File::hasAPETag() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void MPEG::File::read(bool readProperties)
+void MPEG::File::read(ReadParts parts)
 {
+  d->readParts = parts;
+
+  // Without the tags, only their locations and sizes are needed to find the
+  // audio frames.
+
+  const bool readTags = (parts & ReadTags) != 0;
+
   // Look for an ID3v2 tag
 
   d->ID3v2Location = findID3v2();
 
   if(d->ID3v2Location >= 0) {
-    d->tag.set(ID3v2Index, new ID3v2::Tag(this, d->ID3v2Location, d->ID3v2FrameFactory));
-    d->ID3v2OriginalSize = ID3v2Tag()->header()->completeTagSize();
+    if(readTags) {
+      d->tag.set(ID3v2Index, new ID3v2::Tag(this, d->ID3v2Location, d->ID3v2FrameFactory));
+      d->ID3v2OriginalSize = ID3v2Tag()->header()->completeTagSize();
+    }
+    else {
+      seek(d->ID3v2Location);
+      const ID3v2::Header header(readBlock(ID3v2::Header::size()));
+      d->ID3v2OriginalSize = header.completeTagSize();
+    }
   }
 
   // Look for an ID3v1 tag
 
   d->ID3v1Location = Utils::findID3v1(this);
 
-  if(d->ID3v1Location >= 0)
+  if(d->ID3v1Location >= 0 && readTags)
     d->tag.set(ID3v1Index, new ID3v1::Tag(this, d->ID3v1Location));
 
   // Look for an APE tag
@@ -521,13 +607,20 @@ void MPEG::File::read(bool readProperties)
   d->APELocation = Utils::findAPE(this, d->ID3v1Location);
 
   if(d->APELocation >= 0) {
-    d->tag.set(APEIndex, new APE::Tag(this, d->APELocation));
-    d->APEOriginalSize = APETag()->footer()->completeTagSize();
+    if(readTags) {
+      d->tag.set(APEIndex, new APE::Tag(this, d->APELocation));
+      d->APEOriginalSize = APETag()->footer()->completeTagSize();
+    }
+    else {
+      seek(d->APELocation);
+      const APE::Footer footer(readBlock(APE::Footer::size()));
+      d->APEOriginalSize = footer.completeTagSize();
+    }
     d->APELocation = d->APELocation + APE::Footer::size() - d->APEOriginalSize;
   }
 
-  if(readProperties)
-    d->properties = new Properties(this);
+  if(parts & ReadProperties)
+    d->properties = new Properties(this, d->readStyle);
 
   // Make sure that we have our default tag types available.
 
@@ -541,21 +634,14 @@ long MPEG::File::findID3v2()
     return -1;
 
   // An ID3v2 tag or MPEG frame is most likely be at the beginning of the file.
+  // Look for an ID3v2 tag until reaching the first valid MPEG frame.
 
-  const ByteVector headerID = ID3v2::Header::fileIdentifier();
-
-  seek(0);
-  if(readBlock(headerID.size()) == headerID)
-    return 0;
-
-  const Header firstHeader(this, 0, true);
-  if(firstHeader.isValid())
-    return -1;
+  // The last two bytes of the previous buffer are kept in front of the current
+  // one, so that a header which straddles the buffers is not missed.
 
-  // Look for an ID3v2 tag until reaching the first valid MPEG frame.
+  const ByteVector headerID = ID3v2::Header::fileIdentifier();
 
-  ByteVector frameSyncBytes(2, '\0');
-  ByteVector tagHeaderBytes(3, '\0');
+  ByteVector window;
   long position = 0;
 
   while(true) {
@@ -564,22 +650,22 @@ long MPEG::File::findID3v2()
     if(buffer.isEmpty())
       return -1;
 
-    for(unsigned int i = 0; i < buffer.size(); ++i) {
-      frameSyncBytes[0] = frameSyncBytes[1];
-      frameSyncBytes[1] = buffer[i];
-      if(isFrameSync(frameSyncBytes)) {
-        const Header header(this, position + i - 1, true);
-        if(header.isValid())
-          return -1;
-      }
+    const unsigned int carried = window.size();
+    const long windowOffset = position - carried;
+
+    window.append(buffer);
+
+    const char *data = window.data();
+    for(unsigned int i = 0; i < window.size() - 1; ++i) {
+      if(i + 1 >= carried && isFrameSync(data + i) &&
+         validFrameLength(this, window, windowOffset, windowOffset + i) > 0)
+        return -1;
 
-      tagHeaderBytes[0] = tagHeaderBytes[1];
-      tagHeaderBytes[1] = tagHeaderBytes[2];
-      tagHeaderBytes[2] = buffer[i];
-      if(tagHeaderBytes == headerID)
-        return position + i - 2;
+      if(i + 2 >= carried && i + 2 < window.size() && window.containsAt(headerID, i))
+        return windowOffset + i;
     }
 
+    window = window.mid(window.size() - std::min<unsigned int>(window.size(), 2));
     position += bufferSize();
   }
 }
@@ -76,7 +76,8 @@ namespace TagLib {
        * Constructs an MPEG file from \a file.  If \a readProperties is true the
        * file's audio properties will also be read.
        *
-       * \note In the current implementation, \a propertiesStyle is ignored.
+       * If \a propertiesStyle is Properties::Accurate, every frame header is
+       * read to calculate the length and bitrate.
        *
        * \deprecated This constructor will be dropped in favor of the one below
        * in a future version.
@@ -91,7 +92,8 @@ namespace TagLib {
        * If this file contains and ID3v2 tag the frames will be created using
        * \a frameFactory.
        *
-       * \note In the current implementation, \a propertiesStyle is ignored.
+       * If \a propertiesStyle is Properties::Accurate, every frame header is
+       * read to calculate the length and bitrate.
        */
       // BIC: merge with the above constructor
       File(FileName file, ID3v2::FrameFactory *frameFactory,
@@ -108,12 +110,42 @@ namespace TagLib {
        * If this file contains and ID3v2 tag the frames will be created using
        * \a frameFactory.
        *
-       * \note In the current implementation, \a propertiesStyle is ignored.
+       * If \a propertiesStyle is Properties::Accurate, every frame header is
+       * read to calculate the length and bitrate.
        */
       File(IOStream *stream, ID3v2::FrameFactory *frameFactory,
            bool readProperties = true,
            Properties::ReadStyle propertiesStyle = Properties::Average);
 
+      /*!
+       * Constructs an MPEG file from \a file and reads only the given \a parts
+       * of it.  Without ReadTags, the tags are only located, but not read, and
+       * the file can not be saved.
+       *
+       * If this file contains and ID3v2 tag the frames will be created using
+       * \a frameFactory.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(FileName file, ID3v2::FrameFactory *frameFactory, ReadParts parts,
+           Properties::ReadStyle propertiesStyle = Properties::Average);
+
+      /*!
+       * Constructs an MPEG file from \a stream and reads only the given
+       * \a parts of it.  Without ReadTags, the tags are only located, but not
+       * read, and the file can not be saved.
+       *
+       * \note TagLib will *not* take ownership of the stream, the caller is
+       * responsible for deleting it after the File object.
+       *
+       * If this file contains and ID3v2 tag the frames will be created using
+       * \a frameFactory.
+       *
+       * \see TagLib::File::ReadParts
+       */
+      File(IOStream *stream, ID3v2::FrameFactory *frameFactory, ReadParts parts,
+           Properties::ReadStyle propertiesStyle = Properties::Average);
+
       /*!
        * Destroys this instance of the File.
        */
@@ -375,7 +407,7 @@ namespace TagLib {
       File(const File &);
       File &operator=(const File &);
 
-      void read(bool readProperties);
+      void read(ReadParts parts);
       long findID3v2();
 
       class FilePrivate;
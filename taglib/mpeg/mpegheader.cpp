@@ -187,80 +187,21 @@ void MPEG::Header::parse(File *file, long offset, bool checkLength)
     return;
   }
 
-  // Set the MPEG version
+  // Decode the version, layer, bitrate, sample rate and frame length.
 
-  const int versionBits = (static_cast<unsigned char>(data[1]) >> 3) & 0x03;
-
-  if(versionBits == 0)
-    d->version = Version2_5;
-  else if(versionBits == 2)
-    d->version = Version2;
-  else if(versionBits == 3)
-    d->version = Version1;
-  else
+  FrameHeader header;
+  if(!decodeFrameHeader(data.data(), header))
     return;
 
-  // Set the MPEG layer
-
-  const int layerBits = (static_cast<unsigned char>(data[1]) >> 1) & 0x03;
-
-  if(layerBits == 1)
-    d->layer = 3;
-  else if(layerBits == 2)
-    d->layer = 2;
-  else if(layerBits == 3)
-    d->layer = 1;
-  else
-    return;
+  d->version         = static_cast<Version>(header.version);
+  d->layer           = header.layer;
+  d->bitrate         = header.bitrate;
+  d->sampleRate      = header.sampleRate;
+  d->samplesPerFrame = header.samplesPerFrame;
+  d->frameLength     = header.frameLength;
 
   d->protectionEnabled = (static_cast<unsigned char>(data[1] & 0x01) == 0);
 
-  // Set the bitrate
-
-  static const int bitrates[2][3][16] = {
-    { // Version 1
-      { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 }, // layer 1
-      { 0, 32, 48, 56, 64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 384, 0 }, // layer 2
-      { 0, 32, 40, 48, 56,  64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 0 }  // layer 3
-    },
-    { // Version 2 or 2.5
-      { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 }, // layer 1
-      { 0, 8,  16, 24, 32, 40, 48, 56,  64,  80,  96,  112, 128, 144, 160, 0 }, // layer 2
-      { 0, 8,  16, 24, 32, 40, 48, 56,  64,  80,  96,  112, 128, 144, 160, 0 }  // layer 3
-    }
-  };
-
-  const int versionIndex = (d->version == Version1) ? 0 : 1;
-  const int layerIndex   = (d->layer > 0) ? d->layer - 1 : 0;
-
-  // The bitrate index is encoded as the first 4 bits of the 3rd byte,
-  // i.e. 1111xxxx
-
-  const int bitrateIndex = (static_cast<unsigned char>(data[2]) >> 4) & 0x0F;
-
-  d->bitrate = bitrates[versionIndex][layerIndex][bitrateIndex];
-
-  if(d->bitrate == 0)
-    return;
-
-  // Set the sample rate
-
-  static const int sampleRates[3][4] = {
-    { 44100, 48000, 32000, 0 }, // Version 1
-    { 22050, 24000, 16000, 0 }, // Version 2
-    { 11025, 12000, 8000,  0 }  // Version 2.5
-  };
-
-  // The sample rate index is encoded as two bits in the 3nd byte, i.e. xxxx11xx
-
-  const int samplerateIndex = (static_cast<unsigned char>(data[2]) >> 2) & 0x03;
-
-  d->sampleRate = sampleRates[d->version][samplerateIndex];
-
-  if(d->sampleRate == 0) {
-    return;
-  }
-
   // The channel mode is encoded as a 2 bit value at the end of the 3nd byte,
   // i.e. xxxxxx11
 
@@ -272,26 +213,6 @@ void MPEG::Header::parse(File *file, long offset, bool checkLength)
   d->isCopyrighted = ((static_cast<unsigned char>(data[3]) & 0x08) != 0);
   d->isPadded      = ((static_cast<unsigned char>(data[2]) & 0x02) != 0);
 
-  // Samples per frame
-
-  static const int samplesPerFrame[3][2] = {
-    // MPEG1, 2/2.5
-    {  384,   384 }, // Layer I
-    { 1152,  1152 }, // Layer II
-    { 1152,   576 }  // Layer III
-  };
-
-  d->samplesPerFrame = samplesPerFrame[layerIndex][versionIndex];
-
-  // Calculate the frame length
-
-  static const int paddingSize[3] = { 4, 1, 1 };
-
-  d->frameLength = d->samplesPerFrame * d->bitrate * 125 / d->sampleRate;
-
-  if(d->isPadded)
-    d->frameLength += paddingSize[layerIndex];
-
   if(checkLength) {
 
     // Check if the frame length has been calculated correctly, or the next frame
@@ -307,12 +228,7 @@ void MPEG::Header::parse(File *file, long offset, bool checkLength)
     if(nextData.size() < 4)
       return;
 
-    const unsigned int HeaderMask = 0xfffe0c00;
-
-    const unsigned int header     = data.toUInt(0, true)     & HeaderMask;
-    const unsigned int nextHeader = nextData.toUInt(0, true) & HeaderMask;
-
-    if(header != nextHeader)
+    if(!isSameStream(data.data(), nextData.data()))
       return;
   }
 
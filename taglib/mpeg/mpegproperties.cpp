@@ -23,11 +23,14 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+
 #include <tdebug.h>
 #include <tstring.h>
 
 #include "mpegproperties.h"
 #include "mpegfile.h"
+#include "mpegutils.h"
 #include "xingheader.h"
 #include "apetag.h"
 #include "apefooter.h"
@@ -66,6 +69,7 @@ public:
   bool protectionEnabled;
   bool isCopyrighted;
   bool isOriginal;
+  List<long> seekTable;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -76,7 +80,7 @@ MPEG::Properties::Properties(File *file, ReadStyle style) :
   AudioProperties(style),
   d(new PropertiesPrivate())
 {
-  read(file);
+  read(file, style);
 }
 
 MPEG::Properties::~Properties()
@@ -119,6 +123,11 @@ const MPEG::XingHeader *MPEG::Properties::xingHeader() const
   return d->xingHeader;
 }
 
+List<long> MPEG::Properties::seekTable() const
+{
+  return d->seekTable;
+}
+
 MPEG::Header::Version MPEG::Properties::version() const
 {
   return d->version;
@@ -153,7 +162,7 @@ bool MPEG::Properties::isOriginal() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-void MPEG::Properties::read(File *file)
+void MPEG::Properties::read(File *file, ReadStyle style)
 {
   // Only the first valid frame is required if we have a VBR header.
 
@@ -175,7 +184,17 @@ void MPEG::Properties::read(File *file)
     d->xingHeader = 0;
   }
 
-  if(d->xingHeader && firstHeader.samplesPerFrame() > 0 && firstHeader.sampleRate() > 0) {
+  if(style == Accurate) {
+
+    // Walk through all the frame headers.  The frame with the VBR header, if
+    // any, contains no audio.
+
+    if(d->xingHeader)
+      readFrames(file, firstHeader, firstFrameOffset + firstHeader.frameLength());
+    else
+      readFrames(file, firstHeader, firstFrameOffset);
+  }
+  else if(d->xingHeader && firstHeader.samplesPerFrame() > 0 && firstHeader.sampleRate() > 0) {
 
     // Read the length and the bitrate from the VBR header.
 
@@ -219,3 +238,74 @@ void MPEG::Properties::read(File *file)
   d->isCopyrighted     = firstHeader.isCopyrighted();
   d->isOriginal        = firstHeader.isOriginal();
 }
+
+void MPEG::Properties::readFrames(File *file, const Header &firstHeader, long offset)
+{
+  // Read the stream in large chunks and follow the frame lengths through it,
+  // so that only the 4 byte frame headers are looked at.
+
+  static const unsigned int ChunkSize = 256 * 1024;
+
+  const long lastFrameOffset = file->lastFrameOffset();
+  if(lastFrameOffset < offset) {
+    debug("MPEG::Properties::readFrames() -- Could not find an MPEG frame in the stream.");
+    return;
+  }
+
+  const Header lastHeader(file, lastFrameOffset, false);
+  const long streamEnd = lastFrameOffset + lastHeader.frameLength();
+
+  const int version    = firstHeader.version();
+  const int layer      = firstHeader.layer();
+  const int sampleRate = firstHeader.sampleRate();
+
+  unsigned long long frames  = 0;
+  unsigned long long samples = 0;
+  unsigned long long bytes   = 0;
+
+  ByteVector buffer;
+  long bufferOffset = 0;
+
+  while(offset + 4 <= streamEnd) {
+    if(offset < bufferOffset || offset + 4 > bufferOffset + static_cast<long>(buffer.size())) {
+      file->seek(offset);
+      buffer = file->readBlock(std::min<long>(ChunkSize, streamEnd - offset));
+      bufferOffset = offset;
+      if(buffer.size() < 4)
+        break;
+    }
+
+    const char *data = buffer.data() + (offset - bufferOffset);
+
+    FrameHeader header;
+    if(!decodeFrameHeader(data, header) ||
+       header.version    != version ||
+       header.layer      != layer ||
+       header.sampleRate != sampleRate)
+    {
+      // Skip the broken data until the next valid frame.
+
+      offset = file->nextFrameOffset(offset + 1);
+      if(offset < 0)
+        break;
+
+      continue;
+    }
+
+    if(frames % SeekTableInterval == 0)
+      d->seekTable.append(offset);
+
+    frames  += 1;
+    samples += header.samplesPerFrame;
+    bytes   += header.frameLength;
+    offset  += header.frameLength;
+  }
+
+  if(frames == 0)
+    return;
+
+  const double length = samples * 1000.0 / sampleRate;
+
+  d->length  = static_cast<int>(length + 0.5);
+  d->bitrate = static_cast<int>(bytes * 8.0 / length + 0.5);
+}
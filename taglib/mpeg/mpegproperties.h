@@ -27,6 +27,7 @@
 #define TAGLIB_MPEGPROPERTIES_H
 
 #include "taglib_export.h"
+#include "tlist.h"
 #include "audioproperties.h"
 
 #include "mpegheader.h"
@@ -51,6 +52,11 @@ namespace TagLib {
       /*!
        * Create an instance of MPEG::Properties with the data read from the
        * MPEG::File \a file.
+       *
+       * If \a style is Accurate, every frame header of the stream is read to
+       * calculate the exact length and average bitrate, so that VBR streams
+       * without a Xing/VBRI header are measured correctly.  Otherwise a
+       * stream without a VBR header is assumed to have a constant bitrate.
        */
       Properties(File *file, ReadStyle style = Average);
 
@@ -107,6 +113,21 @@ namespace TagLib {
        */
       const XingHeader *xingHeader() const;
 
+      /*!
+       * Returns the offsets of every SeekTableInterval th audio frame, starting
+       * with the first one.  These can be used to seek in the stream without
+       * reading all the preceding frame headers.
+       *
+       * \note This is only available if the properties were read with the
+       * Accurate style, otherwise the list is empty.
+       */
+      List<long> seekTable() const;
+
+      /*!
+       * The number of frames between the entries of seekTable().
+       */
+      static const unsigned int SeekTableInterval = 100;
+
       /*!
        * Returns the MPEG Version of the file.
        */
@@ -141,7 +162,8 @@ namespace TagLib {
       Properties(const Properties &);
       Properties &operator=(const Properties &);
 
-      void read(File *file);
+      void read(File *file, ReadStyle style);
+      void readFrames(File *file, const Header &firstHeader, long offset);
 
       class PropertiesPrivate;
       PropertiesPrivate *d;
@@ -54,6 +54,112 @@ namespace TagLib
         return (b1 == 0xFF && b2 != 0xFF && (b2 & 0xE0) == 0xE0);
       }
 
+      inline bool isFrameSync(const char *data)
+      {
+        const unsigned char b1 = static_cast<unsigned char>(data[0]);
+        const unsigned char b2 = static_cast<unsigned char>(data[1]);
+        return (b1 == 0xFF && b2 != 0xFF && (b2 & 0xE0) == 0xE0);
+      }
+
+      /*!
+       * The fields of an MPEG frame header which are needed to locate frames.
+       * \a version has the values of MPEG::Header::Version.
+       */
+      struct FrameHeader
+      {
+        int version;
+        int layer;
+        int bitrate;
+        int sampleRate;
+        int samplesPerFrame;
+        int frameLength;
+      };
+
+      /*!
+       * The bits which should not differ between two consecutive frame headers of
+       * a stream: the synch bits, version, layer and sample rate.
+       */
+      const unsigned int FrameHeaderMask = 0xfffe0c00;
+
+      /*!
+       * Decodes the 4 byte MPEG frame header at \a data into \a header without
+       * any file access.  Returns false if \a data is not a valid frame header.
+       */
+      inline bool decodeFrameHeader(const char *data, FrameHeader &header)
+      {
+        static const int versions[4] = { 2, -1, 1, 0 };
+        static const int layers[4]   = { 0, 3, 2, 1 };
+
+        static const int bitrates[2][3][16] = {
+          { // Version 1
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 }, // layer 1
+            { 0, 32, 48, 56, 64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 384, 0 }, // layer 2
+            { 0, 32, 40, 48, 56,  64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 0 }  // layer 3
+          },
+          { // Version 2 or 2.5
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 }, // layer 1
+            { 0, 8,  16, 24, 32, 40, 48, 56,  64,  80,  96,  112, 128, 144, 160, 0 }, // layer 2
+            { 0, 8,  16, 24, 32, 40, 48, 56,  64,  80,  96,  112, 128, 144, 160, 0 }  // layer 3
+          }
+        };
+
+        static const int sampleRates[3][4] = {
+          { 44100, 48000, 32000, 0 }, // Version 1
+          { 22050, 24000, 16000, 0 }, // Version 2
+          { 11025, 12000, 8000,  0 }  // Version 2.5
+        };
+
+        static const int samplesPerFrame[3][2] = {
+          // MPEG1, 2/2.5
+          {  384,   384 }, // Layer I
+          { 1152,  1152 }, // Layer II
+          { 1152,   576 }  // Layer III
+        };
+
+        static const int paddingSize[3] = { 4, 1, 1 };
+
+        if(!isFrameSync(data))
+          return false;
+
+        const unsigned char b2 = static_cast<unsigned char>(data[1]);
+        const unsigned char b3 = static_cast<unsigned char>(data[2]);
+
+        header.version = versions[(b2 >> 3) & 0x03];
+        header.layer   = layers[(b2 >> 1) & 0x03];
+        if(header.version < 0 || header.layer == 0)
+          return false;
+
+        const int versionIndex = (header.version == 0) ? 0 : 1;
+        const int layerIndex   = header.layer - 1;
+
+        header.bitrate    = bitrates[versionIndex][layerIndex][(b3 >> 4) & 0x0F];
+        header.sampleRate = sampleRates[header.version][(b3 >> 2) & 0x03];
+        if(header.bitrate == 0 || header.sampleRate == 0)
+          return false;
+
+        header.samplesPerFrame = samplesPerFrame[layerIndex][versionIndex];
+        header.frameLength = header.samplesPerFrame * header.bitrate * 125 / header.sampleRate;
+
+        if(b3 & 0x02)
+          header.frameLength += paddingSize[layerIndex];
+
+        return true;
+      }
+
+      /*!
+       * Returns true if the frame headers at \a data and \a nextData may belong
+       * to the same stream.
+       */
+      inline bool isSameStream(const char *data, const char *nextData)
+      {
+        for(int i = 0; i < 4; ++i) {
+          const unsigned char mask = static_cast<unsigned char>(FrameHeaderMask >> (24 - i * 8));
+          if((data[i] & mask) != (nextData[i] & mask))
+            return false;
+        }
+        return true;
+      }
+
     }
   }
 }
@@ -23,12 +23,15 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+
 #include <tbytevector.h>
 #include <tstring.h>
 #include <tdebug.h>
 
 #include "xingheader.h"
 #include "mpegfile.h"
+#include "mpegutils.h"
 
 using namespace TagLib;
 
@@ -38,12 +41,34 @@ public:
   XingHeaderPrivate() :
     frames(0),
     size(0),
-    type(MPEG::XingHeader::Invalid) {}
+    type(MPEG::XingHeader::Invalid),
+    length(0.0),
+    quality(-1),
+    vbrMethod(0),
+    lowpassFilter(0),
+    encoderDelay(0),
+    encoderPadding(0) {}
 
   unsigned int frames;
   unsigned int size;
 
   MPEG::XingHeader::HeaderType type;
+
+  // The length of the stream in milliseconds and the table of contents of
+  // the Xing header.
+
+  double length;
+  ByteVector toc;
+
+  int quality;
+
+  // The fields of the LAME tag.
+
+  String encoderVersion;
+  int vbrMethod;
+  int lowpassFilter;
+  int encoderDelay;
+  int encoderPadding;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -81,6 +106,71 @@ MPEG::XingHeader::HeaderType MPEG::XingHeader::type() const
   return d->type;
 }
 
+bool MPEG::XingHeader::hasTableOfContents() const
+{
+  return (!d->toc.isEmpty() && d->length > 0.0);
+}
+
+long MPEG::XingHeader::seekOffset(int milliseconds) const
+{
+  if(!hasTableOfContents())
+    return -1;
+
+  // Each of the 100 entries holds the position of a percent of the playing
+  // time as a fraction of 256 of the stream size.  Interpolate linearly
+  // between them.
+
+  double percent = milliseconds * 100.0 / d->length;
+  if(percent < 0.0)
+    percent = 0.0;
+  else if(percent > 100.0)
+    percent = 100.0;
+
+  const ByteVector &toc = d->toc;
+  const int index = std::min(static_cast<int>(percent), 99);
+
+  const double a = static_cast<unsigned char>(toc[index]);
+  const double b = (index < 99) ? static_cast<unsigned char>(toc[index + 1]) : 256.0;
+  const double position = a + (b - a) * (percent - index);
+
+  return static_cast<long>(position / 256.0 * d->size);
+}
+
+int MPEG::XingHeader::quality() const
+{
+  return d->quality;
+}
+
+bool MPEG::XingHeader::hasLAMETag() const
+{
+  return !d->encoderVersion.isEmpty();
+}
+
+String MPEG::XingHeader::encoderVersion() const
+{
+  return d->encoderVersion;
+}
+
+int MPEG::XingHeader::vbrMethod() const
+{
+  return d->vbrMethod;
+}
+
+int MPEG::XingHeader::lowpassFilter() const
+{
+  return d->lowpassFilter;
+}
+
+int MPEG::XingHeader::encoderDelay() const
+{
+  return d->encoderDelay;
+}
+
+int MPEG::XingHeader::encoderPadding() const
+{
+  return d->encoderPadding;
+}
+
 int MPEG::XingHeader::xingHeaderOffset(TagLib::MPEG::Header::Version /*v*/,
                                        TagLib::MPEG::Header::ChannelMode /*c*/)
 {
@@ -116,6 +206,50 @@ void MPEG::XingHeader::parse(const ByteVector &data)
     d->frames = data.toUInt(offset + 8,  true);
     d->size   = data.toUInt(offset + 12, true);
     d->type   = Xing;
+
+    // The optional table of contents and quality indicator follow.
+
+    const unsigned char flags = data[offset + 7];
+    unsigned int pos = offset + 16;
+
+    if(flags & 0x04) {
+      if(data.size() >= pos + 100)
+        d->toc = data.mid(pos, 100);
+      pos += 100;
+    }
+
+    if(flags & 0x08) {
+      if(data.size() >= pos + 4)
+        d->quality = static_cast<int>(data.toUInt(pos, true));
+      pos += 4;
+    }
+
+    // The playing time is needed to look up positions in the table of contents.
+    // The data begins with the header of the frame which contains this header.
+
+    FrameHeader header;
+    if(!d->toc.isEmpty() && data.size() >= 4 && decodeFrameHeader(data.data(), header))
+      d->length = d->frames * 1000.0 * header.samplesPerFrame / header.sampleRate;
+
+    // LAME and the encoders based on its library put their tag right after the
+    // Xing header.
+
+    if(data.size() >= pos + 36 &&
+       (data.containsAt("LAME", pos) || data.containsAt("Lavf", pos) || data.containsAt("Lavc", pos)))
+    {
+      const ByteVector version = data.mid(pos, 9);
+      const int end = version.find('\0');
+      d->encoderVersion = String(end < 0 ? version : version.mid(0, end)).stripWhiteSpace();
+
+      d->vbrMethod     = static_cast<unsigned char>(data[pos + 9]) & 0x0F;
+      d->lowpassFilter = static_cast<unsigned char>(data[pos + 10]) * 100;
+
+      // The encoder delay and padding are 12 bit values.
+
+      const unsigned int delays = data.toUInt(pos + 21, 3, true);
+      d->encoderDelay   = (delays >> 12) & 0x0FFF;
+      d->encoderPadding = delays & 0x0FFF;
+    }
   }
   else {
 
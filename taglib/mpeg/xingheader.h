@@ -27,6 +27,7 @@
 #define TAGLIB_XINGHEADER_H
 
 #include "mpegheader.h"
+#include "tstring.h"
 #include "taglib_export.h"
 
 namespace TagLib {
@@ -43,10 +44,12 @@ namespace TagLib {
      * This is a minimalistic implementation of the Xing/VBRI VBR headers.
      * Xing/VBRI headers are often added to VBR (variable bit rate) MP3 streams
      * to make it easy to compute the length and quality of a VBR stream.  Our
-     * implementation is only concerned with the total size of the stream (so
-     * that we can calculate the total playing time and the average bitrate).
+     * implementation reads the total size of the stream (so that we can
+     * calculate the total playing time and the average bitrate), the seek table
+     * of Xing headers and the LAME tag which may follow them.
      * It uses <a href="http://home.pcisys.net/~melanson/codecs/mp3extensions.txt">
-     * this text</a> and the XMMS sources as references.
+     * this text</a>, <a href="http://gabriel.mp3-tech.org/mp3infotag.html">
+     * the LAME tag specification</a> and the XMMS sources as references.
      */
 
     class TAGLIB_EXPORT XingHeader
@@ -105,6 +108,68 @@ namespace TagLib {
        */
       HeaderType type() const;
 
+      /*!
+       * Returns true if the Xing header has a table of contents, which allows
+       * seekOffset() to find a position in the stream without reading it.
+       */
+      bool hasTableOfContents() const;
+
+      /*!
+       * Returns the approximate byte offset of the position \a milliseconds
+       * into the stream, looked up in the table of contents of the Xing header.
+       * The offset is relative to the start of the MPEG frame which contains
+       * this header, i.e. MPEG::File::firstFrameOffset().
+       *
+       * Returns -1 if there is no table of contents.
+       *
+       * \see hasTableOfContents()
+       */
+      long seekOffset(int milliseconds) const;
+
+      /*!
+       * Returns the VBR quality indicator of the Xing header, from 0 (best) to
+       * 100 (worst), or -1 if it is not present.
+       */
+      int quality() const;
+
+      /*!
+       * Returns true if a LAME tag follows the Xing header.  It holds the
+       * encoder settings and the gapless playback information.
+       */
+      bool hasLAMETag() const;
+
+      /*!
+       * Returns the short encoder version string of the LAME tag, e.g.
+       * "LAME3.99r", or an empty string if there is no LAME tag.
+       */
+      String encoderVersion() const;
+
+      /*!
+       * Returns the VBR method of the LAME tag: 1 for CBR, 2 for ABR and 3 to 6
+       * for the VBR modes.  Returns 0 if unknown or if there is no LAME tag.
+       */
+      int vbrMethod() const;
+
+      /*!
+       * Returns the lowpass filter frequency in Hz the stream was encoded with,
+       * or 0 if unknown or if there is no LAME tag.
+       */
+      int lowpassFilter() const;
+
+      /*!
+       * Returns the number of samples the encoder added at the beginning of the
+       * stream, which gapless players should skip.  Returns 0 if there is no
+       * LAME tag.
+       */
+      int encoderDelay() const;
+
+      /*!
+       * Returns the number of samples the encoder added at the end of the
+       * stream to fill the last frame, which gapless players should skip.
+       * Returns 0 if there is no LAME tag.
+       */
+      int encoderPadding() const;
+
       /*!
        * Returns the offset for the start of this Xing header, given the
        * version and channels of the frame
@@ -23,6 +23,10 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include <tbytevectorlist.h>
 #include <tmap.h>
 #include <tstring.h>
@@ -36,12 +40,74 @@ using namespace TagLib;
 
 namespace
 {
+  // A summary of a page of the stream, enough to locate its packets without
+  // reading the page header again.
+  struct PageEntry
+  {
+    long offset;
+    int headerSize;
+    int size;
+    int sequenceNumber;
+    unsigned int firstPacketIndex;
+    unsigned int packetCount;
+    unsigned int firstPacketSize;
+    bool lastPacketCompleted;
+    bool lastPageOfStream;
+
+    // The granule position of this page, or of the nearest page before it if
+    // no packet ends on this page.  This never decreases along the stream.
+    long long granulePosition;
+  };
+
   // Returns the first packet index of the right next page to the given one.
-  unsigned int nextPacketIndex(const Ogg::Page *page)
+  unsigned int nextPacketIndex(const PageEntry &page)
+  {
+    if(page.lastPacketCompleted)
+      return page.firstPacketIndex + page.packetCount;
+    return page.firstPacketIndex + page.packetCount - 1;
+  }
+
+  // Comparators to binary-search the pages by the packet index or granule
+  // position.
+  bool endsBeforePacket(const PageEntry &page, unsigned int i)
+  {
+    return page.firstPacketIndex + page.packetCount <= i;
+  }
+
+  bool endsBeforeGranule(const PageEntry &page, long long granulePosition)
   {
-    if(page->header()->lastPacketCompleted())
-      return page->firstPacketIndex() + page->packetCount();
-    return page->firstPacketIndex() + page->packetCount() - 1;
+    return page.granulePosition < granulePosition;
+  }
+
+  // The largest possible Ogg page: a 27 byte header with 255 lacing values,
+  // each of which is 255.
+  const unsigned int MaxPageSize = 27 + 255 + 255 * 255;
+
+  // Returns the size of the Ogg page at \a pos in \a data, or 0 if there is
+  // no complete page with a valid checksum.
+  unsigned int validPageSize(const ByteVector &data, unsigned int pos)
+  {
+    if(pos + 27 > data.size() || data[pos + 4] != 0)
+      return 0;
+
+    const unsigned int headerSize = 27 + static_cast<unsigned char>(data[pos + 26]);
+    if(pos + headerSize > data.size())
+      return 0;
+
+    unsigned int pageSize = headerSize;
+    for(unsigned int i = pos + 27; i < pos + headerSize; ++i)
+      pageSize += static_cast<unsigned char>(data[i]);
+
+    if(pos + pageSize > data.size())
+      return 0;
+
+    ByteVector page(data.data() + pos, pageSize);
+    const unsigned int checksum = page.toUInt(22, false);
+    std::fill(page.begin() + 22, page.begin() + 26, '\0');
+    if(page.checksum() != checksum)
+      return 0;
+
+    return pageSize;
   }
 }  // namespace
 
@@ -49,11 +115,10 @@ class Ogg::File::FilePrivate
 {
 public:
   FilePrivate() :
+    streamEnded(false),
     firstPageHeader(0),
-    lastPageHeader(0)
-  {
-    pages.setAutoDelete(true);
-  }
+    lastPageHeader(0),
+    lastPageOffset(-1) {}
 
   ~FilePrivate()
   {
@@ -61,10 +126,74 @@ public:
     delete lastPageHeader;
   }
 
+  // Returns the page where the packet \a i begins, which must have been
+  // indexed.
+  std::vector<PageEntry>::const_iterator findPage(unsigned int i) const
+  {
+    return std::lower_bound(pages.begin(), pages.end(), i, endsBeforePacket);
+  }
+
+  // Reads the \a k-th packet of \a page, or its part on the page.
+  ByteVector readPacket(File *file, const PageEntry &page, unsigned int k) const
+  {
+    long offset = page.offset + page.headerSize;
+    for(unsigned int j = 0; j < k; ++j)
+      offset += packetSizes[page.firstPacketSize + j];
+
+    file->seek(offset);
+    return file->readBlock(packetSizes[page.firstPacketSize + k]);
+  }
+
+  // Looks for the last pages in the last MaxPageSize bytes of the file, which
+  // always contain the last page unless the file has trailing garbage.  Only
+  // pages with valid checksums are taken.  Unless \a allStreams is true, only
+  // the pages of the stream which the first page belongs to are checked.
+  void scanTail(File *file, bool allStreams)
+  {
+    const long tailOffset = std::max<long>(0, file->length() - MaxPageSize);
+    file->seek(tailOffset);
+    const ByteVector tail = file->readBlock(MaxPageSize);
+
+    const PageHeader *first = file->firstPageHeader();
+
+    lastPageOffset = -1;
+    lastGranulePositions.clear();
+
+    const char *data = tail.data();
+    for(int pos = static_cast<int>(tail.size()) - 27; pos >= 0; --pos) {
+      if(data[pos] != 'O' || ::memcmp(data + pos, "OggS", 4) != 0)
+        continue;
+
+      // Only the last page of each stream needs to be validated.
+
+      const unsigned int serialNumber = tail.toUInt(pos + 14, false);
+      const bool isFirstStream = !first || first->streamSerialNumber() == serialNumber;
+      if(!isFirstStream && !allStreams)
+        continue;
+
+      if(lastGranulePositions.contains(serialNumber) && (!isFirstStream || lastPageOffset >= 0))
+        continue;
+
+      if(validPageSize(tail, pos) == 0)
+        continue;
+
+      if(isFirstStream && lastPageOffset < 0)
+        lastPageOffset = tailOffset + pos;
+
+      const long long granulePosition = tail.toLongLong(pos + 6, false);
+      if(granulePosition != -1 && !lastGranulePositions.contains(serialNumber))
+        lastGranulePositions.insert(serialNumber, granulePosition);
+    }
+  }
+
   unsigned int streamSerialNumber;
-  List<Page *> pages;
+  std::vector<PageEntry> pages;
+  std::vector<int> packetSizes;
+  bool streamEnded;
   PageHeader *firstPageHeader;
   PageHeader *lastPageHeader;
+  long lastPageOffset;
+  Map<unsigned int, long long> lastGranulePositions;
   Map<unsigned int, ByteVector> dirtyPackets;
 };
 
@@ -95,9 +224,7 @@ ByteVector Ogg::File::packet(unsigned int i)
 
   // Look for the first page in which the requested packet starts.
 
-  List<Page *>::ConstIterator it = d->pages.begin();
-  while((*it)->containsPacket(i) == Page::DoesNotContainPacket)
-    ++it;
+  std::vector<PageEntry>::const_iterator it = d->findPage(i);
 
   // If the packet is completely contained in the first page that it's in.
 
@@ -106,11 +233,11 @@ ByteVector Ogg::File::packet(unsigned int i)
   // the pages' packet data until we hit a page that either does not end with the
   // packet that we're fetching or where the last packet is complete.
 
-  ByteVector packet = (*it)->packets()[i - (*it)->firstPacketIndex()];
+  ByteVector packet = d->readPacket(this, *it, i - it->firstPacketIndex);
 
   while(nextPacketIndex(*it) <= i) {
     ++it;
-    packet.append((*it)->packets().front());
+    packet.append(d->readPacket(this, *it, 0));
   }
 
   return packet;
@@ -142,7 +269,23 @@ const Ogg::PageHeader *Ogg::File::firstPageHeader()
 const Ogg::PageHeader *Ogg::File::lastPageHeader()
 {
   if(!d->lastPageHeader) {
-    const long lastPageHeaderOffset = rfind("OggS");
+    long lastPageHeaderOffset;
+
+    // If the whole stream has been indexed, the last page is known.  Otherwise
+    // it should be found at the end of the file.  Search further back only if
+    // the file has trailing garbage.
+
+    if(d->streamEnded && !d->pages.empty() && d->pages.back().lastPageOfStream) {
+      lastPageHeaderOffset = d->pages.back().offset;
+    }
+    else {
+      d->scanTail(this, false);
+
+      lastPageHeaderOffset = d->lastPageOffset;
+      if(lastPageHeaderOffset < 0)
+        lastPageHeaderOffset = rfind("OggS");
+    }
+
     if(lastPageHeaderOffset < 0)
       return 0;
 
@@ -152,6 +295,32 @@ const Ogg::PageHeader *Ogg::File::lastPageHeader()
   return d->lastPageHeader->isValid() ? d->lastPageHeader : 0;
 }
 
+Map<unsigned int, long long> Ogg::File::lastGranulePositions()
+{
+  d->scanTail(this, true);
+
+  return d->lastGranulePositions;
+}
+
+long Ogg::File::findGranulePosition(long long granulePosition)
+{
+  std::vector<PageEntry>::const_iterator it
+    = std::lower_bound(d->pages.begin(), d->pages.end(), granulePosition, endsBeforeGranule);
+
+  // Index further pages until one reaches the granule position.
+
+  while(it == d->pages.end()) {
+    const unsigned int indexedPages = static_cast<unsigned int>(d->pages.size());
+    if(!readNextPage())
+      return -1;
+
+    it = std::lower_bound(d->pages.begin() + indexedPages, d->pages.end(),
+                          granulePosition, endsBeforeGranule);
+  }
+
+  return it->offset;
+}
+
 bool Ogg::File::save()
 {
   if(readOnly()) {
@@ -190,41 +359,71 @@ Ogg::File::File(IOStream *stream) :
 
 bool Ogg::File::readPages(unsigned int i)
 {
-  while(true) {
-    unsigned int packetIndex;
-    long offset;
+  while(d->pages.empty() || nextPacketIndex(d->pages.back()) <= i) {
+    if(!readNextPage())
+      return false;
 
-    if(d->pages.isEmpty()) {
-      packetIndex = 0;
-      offset = find("OggS");
-      if(offset < 0)
-        return false;
-    }
-    else {
-      const Page *page = d->pages.back();
-      packetIndex = nextPacketIndex(page);
-      offset = page->fileOffset() + page->size();
-    }
+    if(d->pages.back().lastPageOfStream)
+      return false;
+  }
 
-    // Enough pages have been fetched.
+  return true;
+}
 
-    if(packetIndex > i)
-      return true;
+bool Ogg::File::readNextPage()
+{
+  if(d->streamEnded)
+    return false;
 
-    // Read the next page and add it to the page list.
+  unsigned int packetIndex;
+  long offset;
+  long long granulePosition;
 
-    Page *nextPage = new Page(this, offset);
-    if(!nextPage->header()->isValid()) {
-      delete nextPage;
+  if(d->pages.empty()) {
+    packetIndex = 0;
+    offset = find("OggS");
+    granulePosition = -1;
+    if(offset < 0) {
+      d->streamEnded = true;
       return false;
     }
+  }
+  else {
+    const PageEntry &page = d->pages.back();
+    packetIndex = nextPacketIndex(page);
+    offset = page.offset + page.size;
+    granulePosition = page.granulePosition;
+  }
 
-    nextPage->setFirstPacketIndex(packetIndex);
-    d->pages.append(nextPage);
+  // Read the next page header and add the page to the index.
 
-    if(nextPage->header()->lastPageOfStream())
-      return false;
+  const PageHeader header(this, offset);
+  if(!header.isValid()) {
+    d->streamEnded = true;
+    return false;
   }
+
+  const List<int> sizes = header.packetSizes();
+
+  PageEntry page;
+  page.offset              = offset;
+  page.headerSize          = header.size();
+  page.size                = header.size() + header.dataSize();
+  page.sequenceNumber      = header.pageSequenceNumber();
+  page.firstPacketIndex    = packetIndex;
+  page.packetCount         = sizes.size();
+  page.firstPacketSize     = static_cast<unsigned int>(d->packetSizes.size());
+  page.lastPacketCompleted = header.lastPacketCompleted();
+  page.lastPageOfStream    = header.lastPageOfStream();
+  page.granulePosition     = std::max(granulePosition, header.absoluteGranularPosition());
+
+  d->packetSizes.insert(d->packetSizes.end(), sizes.begin(), sizes.end());
+  d->pages.push_back(page);
+
+  if(page.lastPageOfStream)
+    d->streamEnded = true;
+
+  return true;
 }
 
 void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
@@ -236,24 +435,22 @@ void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
 
   // Look for the pages where the requested packet should belong to.
 
-  List<Page *>::ConstIterator it = d->pages.begin();
-  while((*it)->containsPacket(i) == Page::DoesNotContainPacket)
-    ++it;
+  const std::vector<PageEntry>::const_iterator first = d->findPage(i);
 
-  const Page *firstPage = *it;
-
-  while(nextPacketIndex(*it) <= i)
-    ++it;
+  std::vector<PageEntry>::const_iterator last = first;
+  while(nextPacketIndex(*last) <= i)
+    ++last;
 
-  const Page *lastPage = *it;
+  const Page firstPage(this, first->offset);
+  const Page lastPage(this, last->offset);
 
   // Replace the requested packet and create new pages to replace the located pages.
 
-  ByteVectorList packets = firstPage->packets();
-  packets[i - firstPage->firstPacketIndex()] = packet;
+  ByteVectorList packets = firstPage.packets();
+  packets[i - first->firstPacketIndex] = packet;
 
-  if(firstPage != lastPage && lastPage->packetCount() > 1) {
-    ByteVectorList lastPagePackets = lastPage->packets();
+  if(first != last && lastPage.packetCount() > 1) {
+    ByteVectorList lastPagePackets = lastPage.packets();
     lastPagePackets.erase(lastPagePackets.begin());
     packets.append(lastPagePackets);
   }
@@ -263,27 +460,27 @@ void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
 
   List<Page *> pages = Page::paginate(packets,
                                       Page::SinglePagePerGroup,
-                                      firstPage->header()->streamSerialNumber(),
-                                      firstPage->pageSequenceNumber(),
-                                      firstPage->header()->firstPacketContinued(),
-                                      lastPage->header()->lastPacketCompleted());
+                                      firstPage.header()->streamSerialNumber(),
+                                      firstPage.pageSequenceNumber(),
+                                      firstPage.header()->firstPacketContinued(),
+                                      lastPage.header()->lastPacketCompleted());
   pages.setAutoDelete(true);
 
   // Write the pages.
 
   ByteVector data;
-  for(it = pages.begin(); it != pages.end(); ++it)
+  for(List<Page *>::ConstIterator it = pages.begin(); it != pages.end(); ++it)
     data.append((*it)->render());
 
-  const unsigned long originalOffset = firstPage->fileOffset();
-  const unsigned long originalLength = lastPage->fileOffset() + lastPage->size() - originalOffset;
+  const unsigned long originalOffset = firstPage.fileOffset();
+  const unsigned long originalLength = lastPage.fileOffset() + lastPage.size() - originalOffset;
 
   insert(data, originalOffset, originalLength);
 
   // Renumber the following pages if the pages have been split or merged.
 
   const int numberOfNewPages
-    = pages.back()->pageSequenceNumber() - lastPage->pageSequenceNumber();
+    = pages.back()->pageSequenceNumber() - lastPage.pageSequenceNumber();
 
   if(numberOfNewPages != 0) {
     long pageOffset = originalOffset + data.size();
@@ -306,7 +503,9 @@ void Ogg::File::writePacket(unsigned int i, const ByteVector &packet)
     }
   }
 
-  // Discard all the pages to keep them up-to-date by fetching them again.
+  // Discard the page index to keep it up-to-date by reading the pages again.
 
   d->pages.clear();
+  d->packetSizes.clear();
+  d->streamEnded = false;
 }
@@ -26,6 +26,7 @@
 #include "taglib_export.h"
 #include "tfile.h"
 #include "tbytevectorlist.h"
+#include "tmap.h"
 
 #ifndef TAGLIB_OGGFILE_H
 #define TAGLIB_OGGFILE_H
@@ -75,9 +76,37 @@ namespace TagLib {
       /*!
        * Returns a pointer to the PageHeader for the last page in the stream or
        * null if the page could not be found.
+       *
+       * If the file contains multiplexed streams, this is the last page of the
+       * stream which the first page belongs to.
        */
       const PageHeader *lastPageHeader();
 
+      /*!
+       * Returns the granule positions of the last pages of the logical streams
+       * which end in the last 64 KiB of the file, keyed by their serial
+       * numbers.  Pages on which no packet ends are not taken into account.
+       *
+       * This is useful to get the durations of multiplexed streams.
+       *
+       * \see lastPageHeader()
+       */
+      Map<unsigned int, long long> lastGranulePositions();
+
+      /*!
+       * Returns the offset of the first page whose granule position is equal
+       * to or greater than \a granulePosition, that is the page where the
+       * sample at \a granulePosition is finished.  Returns -1 if the stream
+       * ends before it.
+       *
+       * The pages are indexed while reading the stream, so this reads each
+       * page header at most once, and looking up the pages which have already
+       * been read does not access the file.
+       *
+       * \note This assumes that the file contains a single logical stream.
+       */
+      long findGranulePosition(long long granulePosition);
+
       virtual bool save();
 
     protected:
@@ -112,6 +141,11 @@ namespace TagLib {
        */
       bool readPages(unsigned int i);
 
+      /*!
+       * Adds the page following the last indexed one to the page index.
+       */
+      bool readNextPage();
+
       /*!
        * Writes the requested packet to the file.
        */
@@ -140,7 +140,7 @@ bool RIFF::AIFF::File::save(ID3v2::Version version)
   }
 
   if(tag() && !tag()->isEmpty()) {
-    setChunkData("ID3 ", d->tag->render(version));
+    setChunkData("ID3 ", d->tag->render(version, this));
     d->hasID3v2 = true;
   }
 
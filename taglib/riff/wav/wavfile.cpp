@@ -176,7 +176,7 @@ bool RIFF::WAV::File::save(TagTypes tags, StripTags strip, ID3v2::Version versio
     removeTagChunks(ID3v2);
 
     if(ID3v2Tag() && !ID3v2Tag()->isEmpty()) {
-      setChunkData("ID3 ", ID3v2Tag()->render(version));
+      setChunkData("ID3 ", ID3v2Tag()->render(version, this));
       d->hasID3v2 = true;
     }
   }
@@ -111,6 +111,52 @@ int findVector(
   return -1;
 }
 
+// Fast paths for forward searches without alignment, which is what File::find()
+// does over large parts of a file.  memchr() is heavily optimized in every C
+// library, so we let it skip to the candidates for the first byte.
+
+int findChar(const char *dataBegin, const char *dataEnd, char c, unsigned int offset)
+{
+  const size_t dataSize = dataEnd - dataBegin;
+  if(offset + 1 > dataSize)
+    return -1;
+
+  const void *it = ::memchr(dataBegin + offset, c, dataSize - offset);
+  if(!it)
+    return -1;
+
+  return static_cast<int>(static_cast<const char *>(it) - dataBegin);
+}
+
+int findVector(
+  const char *dataBegin, const char *dataEnd,
+  const char *patternBegin, const char *patternEnd,
+  unsigned int offset)
+{
+  const size_t dataSize    = dataEnd    - dataBegin;
+  const size_t patternSize = patternEnd - patternBegin;
+  if(patternSize == 0 || offset + patternSize > dataSize)
+    return -1;
+
+  if(patternSize == 1)
+    return findChar(dataBegin, dataEnd, *patternBegin, offset);
+
+  // The last position where the pattern can start, plus one.
+
+  const char *last = dataEnd - patternSize + 1;
+
+  for(const char *it = dataBegin + offset; it < last; ++it) {
+    it = static_cast<const char *>(::memchr(it, *patternBegin, last - it));
+    if(!it)
+      break;
+
+    if(::memcmp(it + 1, patternBegin + 1, patternSize - 1) == 0)
+      return static_cast<int>(it - dataBegin);
+  }
+
+  return -1;
+}
+
 template <class T>
 T toNumber(const ByteVector &v, size_t offset, size_t length, bool mostSignificantByteFirst)
 {
@@ -417,12 +463,20 @@ char ByteVector::at(unsigned int index) const
 
 int ByteVector::find(const ByteVector &pattern, unsigned int offset, int byteAlign) const
 {
+  if(byteAlign == 1) {
+    return findVector(
+      data(), data() + size(), pattern.data(), pattern.data() + pattern.size(), offset);
+  }
+
   return findVector<ConstIterator>(
     begin(), end(), pattern.begin(), pattern.end(), offset, byteAlign);
 }
 
 int ByteVector::find(char c, unsigned int offset, int byteAlign) const
 {
+  if(byteAlign == 1)
+    return findChar(data(), data() + size(), c, offset);
+
   return findChar<ConstIterator>(begin(), end(), c, offset, byteAlign);
 }
 
@@ -0,0 +1,249 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <list>
+#include <algorithm>
+
+#include "tcachedstream.h"
+#include "tstring.h"
+#include "tdebug.h"
+
+using namespace TagLib;
+
+namespace
+{
+  struct CachedBlock
+  {
+    CachedBlock(long index, const ByteVector &data) :
+      index(index),
+      data(data) {}
+
+    long index;
+    ByteVector data;
+  };
+
+  typedef std::list<CachedBlock> CachedBlockList;
+}
+
+class CachedStream::CachedStreamPrivate
+{
+public:
+  CachedStreamPrivate(IOStream *stream, unsigned int blockSize, unsigned int cacheSize) :
+    stream(stream),
+    blockSize(blockSize > 0 ? blockSize : 64 * 1024),
+    maxBlocks(std::max<unsigned int>(cacheSize / this->blockSize, 1)),
+    position(0),
+    length(-1) {}
+
+  // Returns the block with the given index, reading it from the underlying
+  // stream if it is not cached.  The blocks are kept in order of their last
+  // use, so the least recently used one is dropped when the cache is full.
+
+  ByteVector block(long index)
+  {
+    for(CachedBlockList::iterator it = blocks.begin(); it != blocks.end(); ++it) {
+      if(it->index == index) {
+        if(it != blocks.begin())
+          blocks.splice(blocks.begin(), blocks, it);
+        return blocks.front().data;
+      }
+    }
+
+    stream->seek(index * static_cast<long>(blockSize));
+    blocks.push_front(CachedBlock(index, stream->readBlock(blockSize)));
+
+    if(blocks.size() > maxBlocks)
+      blocks.pop_back();
+
+    return blocks.front().data;
+  }
+
+  IOStream *stream;
+  const unsigned int blockSize;
+  const unsigned int maxBlocks;
+  long position;
+  long length;
+  CachedBlockList blocks;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+CachedStream::CachedStream(IOStream *stream, unsigned int blockSize, unsigned int cacheSize) :
+  d(new CachedStreamPrivate(stream, blockSize, cacheSize))
+{
+}
+
+CachedStream::~CachedStream()
+{
+  delete d;
+}
+
+FileName CachedStream::name() const
+{
+  return d->stream->name();
+}
+
+ByteVector CachedStream::readBlock(unsigned long length)
+{
+  if(!isOpen()) {
+    debug("CachedStream::readBlock() -- invalid stream.");
+    return ByteVector();
+  }
+
+  if(length == 0)
+    return ByteVector();
+
+  // Large reads are usually payloads which are read only once, so there is
+  // no point in keeping them.
+
+  if(length > d->blockSize) {
+    d->stream->seek(d->position);
+    const ByteVector data = d->stream->readBlock(length);
+    d->position += data.size();
+    return data;
+  }
+
+  ByteVector buffer;
+
+  while(length > 0) {
+    const long index = d->position / d->blockSize;
+    const unsigned int offset = static_cast<unsigned int>(d->position % d->blockSize);
+
+    const ByteVector data = d->block(index);
+    if(offset >= data.size())
+      break;
+
+    const unsigned int count = std::min<unsigned int>(static_cast<unsigned int>(length), data.size() - offset);
+
+    // Share the cached data if the whole request is served from one block.
+
+    if(buffer.isEmpty() && count == length)
+      buffer = data.mid(offset, count);
+    else
+      buffer.append(data.mid(offset, count));
+
+    d->position += count;
+    length -= count;
+
+    if(data.size() < d->blockSize)
+      break;
+  }
+
+  return buffer;
+}
+
+void CachedStream::writeBlock(const ByteVector &data)
+{
+  invalidate();
+
+  d->stream->seek(d->position);
+  d->stream->writeBlock(data);
+  d->position = d->stream->tell();
+}
+
+void CachedStream::insert(const ByteVector &data, unsigned long start, unsigned long replace)
+{
+  invalidate();
+
+  d->stream->insert(data, start, replace);
+  d->position = d->stream->tell();
+}
+
+void CachedStream::removeBlock(unsigned long start, unsigned long length)
+{
+  invalidate();
+
+  d->stream->removeBlock(start, length);
+  d->position = d->stream->tell();
+}
+
+bool CachedStream::readOnly() const
+{
+  return d->stream->readOnly();
+}
+
+bool CachedStream::isOpen() const
+{
+  return d->stream->isOpen();
+}
+
+void CachedStream::seek(long offset, Position p)
+{
+  long position;
+  switch(p) {
+  case Beginning:
+    position = offset;
+    break;
+  case Current:
+    position = d->position + offset;
+    break;
+  case End:
+    position = length() + offset;
+    break;
+  default:
+    debug("CachedStream::seek() -- Invalid Position value.");
+    return;
+  }
+
+  if(position < 0) {
+    debug("CachedStream::seek() -- Invalid offset.");
+    return;
+  }
+
+  d->position = position;
+}
+
+void CachedStream::clear()
+{
+  d->stream->clear();
+}
+
+long CachedStream::tell() const
+{
+  return d->position;
+}
+
+long CachedStream::length()
+{
+  if(d->length < 0)
+    d->length = d->stream->length();
+
+  return d->length;
+}
+
+void CachedStream::truncate(long length)
+{
+  invalidate();
+
+  d->stream->truncate(length);
+}
+
+void CachedStream::invalidate()
+{
+  d->blocks.clear();
+  d->length = -1;
+}
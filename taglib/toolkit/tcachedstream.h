@@ -0,0 +1,162 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_CACHEDSTREAM_H
+#define TAGLIB_CACHEDSTREAM_H
+
+#include "taglib_export.h"
+#include "taglib.h"
+#include "tbytevector.h"
+#include "tiostream.h"
+
+namespace TagLib {
+
+  //! A stream which caches the data read from another stream
+
+  /*!
+   * This class wraps another IOStream and reads it in blocks of a fixed size
+   * which start at multiples of the block size.  The most recently used
+   * blocks are kept in memory up to a given total size, so the many small
+   * reads that the parsers do while probing headers are served from a few
+   * large reads of the underlying stream.  This helps a lot when every read
+   * of the underlying stream is expensive, e.g. on network file systems.
+   *
+   * Reads which are larger than a block bypass the cache.  Any modification
+   * of the stream drops the cached blocks.
+   *
+   * Any File can be constructed over this stream:
+   *
+   * \code
+   * FileStream file("foo.mp3");
+   * CachedStream stream(&file);
+   * MPEG::File mp3(&stream, ID3v2::FrameFactory::instance());
+   * \endcode
+   */
+
+  class TAGLIB_EXPORT CachedStream : public IOStream
+  {
+  public:
+    /*!
+     * Construct a CachedStream over \a stream which reads it in blocks of
+     * \a blockSize bytes and keeps at most \a cacheSize bytes of them in
+     * memory.  The block size should be a multiple of the page size of the
+     * underlying storage.
+     *
+     * \note TagLib will *not* take ownership of the stream, the caller is
+     * responsible for deleting it after the CachedStream object.
+     */
+    CachedStream(IOStream *stream, unsigned int blockSize = 64 * 1024,
+                 unsigned int cacheSize = 1024 * 1024);
+
+    /*!
+     * Destroys this CachedStream instance.
+     */
+    virtual ~CachedStream();
+
+    /*!
+     * Returns the name of the underlying stream.
+     */
+    FileName name() const;
+
+    /*!
+     * Reads a block of size \a length at the current get pointer.
+     */
+    ByteVector readBlock(unsigned long length);
+
+    /*!
+     * Attempts to write the block \a data at the current get pointer.
+     */
+    void writeBlock(const ByteVector &data);
+
+    /*!
+     * Insert \a data at position \a start in the file overwriting \a replace
+     * bytes of the original content.
+     *
+     * \note This method is slow since it requires rewriting all of the file
+     * after the insertion point.
+     */
+    void insert(const ByteVector &data, unsigned long start = 0, unsigned long replace = 0);
+
+    /*!
+     * Removes a block of the file starting a \a start and continuing for
+     * \a length bytes.
+     *
+     * \note This method is slow since it involves rewriting all of the file
+     * after the removed portion.
+     */
+    void removeBlock(unsigned long start = 0, unsigned long length = 0);
+
+    /*!
+     * Returns true if the underlying stream is read only.
+     */
+    bool readOnly() const;
+
+    /*!
+     * Returns true if the underlying stream is open.
+     */
+    bool isOpen() const;
+
+    /*!
+     * Move the I/O pointer to \a offset in the stream from position \a p.  This
+     * defaults to seeking from the beginning of the stream.
+     *
+     * \see Position
+     */
+    void seek(long offset, Position p = Beginning);
+
+    /*!
+     * Reset the end-of-stream and error flags on the stream.
+     */
+    void clear();
+
+    /*!
+     * Returns the current offset within the stream.
+     */
+    long tell() const;
+
+    /*!
+     * Returns the length of the stream.
+     */
+    long length();
+
+    /*!
+     * Truncates the stream to a \a length.
+     */
+    void truncate(long length);
+
+    /*!
+     * Drops all the cached blocks.  This has to be called if the underlying
+     * stream has been modified without going through this stream.
+     */
+    void invalidate();
+
+  private:
+    class CachedStreamPrivate;
+    CachedStreamPrivate *d;
+  };
+
+}
+
+#endif
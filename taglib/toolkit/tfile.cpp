@@ -23,8 +23,11 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <algorithm>
+
 #include "tfile.h"
 #include "tfilestream.h"
+#include "toverlaystream.h"
 #include "tstring.h"
 #include "tdebug.h"
 #include "tpropertymap.h"
@@ -33,8 +36,12 @@
 # include <windows.h>
 # include <io.h>
 #else
+# include <errno.h>
 # include <stdio.h>
+# include <stdlib.h>
+# include <fcntl.h>
 # include <unistd.h>
+# include <sys/stat.h>
 #endif
 
 #ifndef R_OK
@@ -66,13 +73,182 @@
 
 using namespace TagLib;
 
+namespace
+{
+  // The temporary file which File::saveAtomically() writes the new contents
+  // to.  It is created next to the original file, so that it is on the same
+  // file system and can be renamed over the original file.
+
+#ifdef _WIN32
+
+  struct TempFile
+  {
+    TempFile() : handle(INVALID_HANDLE_VALUE) {}
+    HANDLE handle;
+    std::wstring name;
+  };
+
+  bool createTempFile(const FileName &fileName, TempFile &temp)
+  {
+#if defined (PLATFORM_WINRT)
+    return false;
+#else
+    temp.name = fileName.wstr() + L".taglib-save";
+    temp.handle = CreateFileW(temp.name.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    return (temp.handle != INVALID_HANDLE_VALUE);
+#endif
+  }
+
+  bool writeTempFile(TempFile &temp, const ByteVector &data)
+  {
+    DWORD length;
+    return (WriteFile(temp.handle, data.data(), static_cast<DWORD>(data.size()), &length, NULL)
+            && length == data.size());
+  }
+
+  bool closeTempFile(TempFile &temp)
+  {
+    const bool flushed = (FlushFileBuffers(temp.handle) != 0);
+    CloseHandle(temp.handle);
+    temp.handle = INVALID_HANDLE_VALUE;
+    return flushed;
+  }
+
+  void removeTempFile(TempFile &temp)
+  {
+    if(temp.handle != INVALID_HANDLE_VALUE) {
+      CloseHandle(temp.handle);
+      temp.handle = INVALID_HANDLE_VALUE;
+    }
+    DeleteFileW(temp.name.c_str());
+  }
+
+  bool replaceFile(const TempFile &temp, const FileName &fileName)
+  {
+    return (MoveFileExW(temp.name.c_str(), fileName.wstr().c_str(),
+                        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+  }
+
+#else
+
+  struct TempFile
+  {
+    TempFile() : fd(-1) {}
+    int fd;
+    std::string name;
+  };
+
+  bool createTempFile(const FileName &fileName, TempFile &temp)
+  {
+    std::string name = std::string(fileName) + ".XXXXXX";
+    temp.fd = ::mkstemp(&name[0]);
+    if(temp.fd < 0)
+      return false;
+
+    temp.name = name;
+
+    // mkstemp() creates the file owned by this process and accessible only by
+    // it, so the owner and permissions of the original file are copied.  Only
+    // the group may be changeable if the file belongs to another user.  The
+    // mode is set last, since changing the owner can clear its set-user-ID
+    // and set-group-ID bits.
+
+    struct stat st;
+    if(::stat(fileName, &st) == 0) {
+      if(::fchown(temp.fd, st.st_uid, st.st_gid) != 0)
+        ::fchown(temp.fd, static_cast<uid_t>(-1), st.st_gid);
+      ::fchmod(temp.fd, st.st_mode & 07777);
+    }
+
+    return true;
+  }
+
+  // Returns the path of the file which fileName refers to, so that a symbolic
+  // link is not replaced by the new file, but its target is.
+
+  std::string resolvePath(const std::string &fileName)
+  {
+    char *resolved = ::realpath(fileName.c_str(), 0);
+    if(!resolved)
+      return fileName;
+
+    const std::string path(resolved);
+    ::free(resolved);
+    return path;
+  }
+
+  bool writeTempFile(TempFile &temp, const ByteVector &data)
+  {
+    const char *buffer = data.data();
+    size_t length = data.size();
+
+    while(length > 0) {
+      const ssize_t n = ::write(temp.fd, buffer, length);
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+
+      buffer += n;
+      length -= n;
+    }
+
+    return true;
+  }
+
+  bool closeTempFile(TempFile &temp)
+  {
+    const bool synced = (::fsync(temp.fd) == 0);
+    const bool closed = (::close(temp.fd) == 0);
+    temp.fd = -1;
+    return synced && closed;
+  }
+
+  void removeTempFile(TempFile &temp)
+  {
+    if(temp.fd >= 0) {
+      ::close(temp.fd);
+      temp.fd = -1;
+    }
+    ::unlink(temp.name.c_str());
+  }
+
+  bool replaceFile(const TempFile &temp, const FileName &fileName)
+  {
+    if(::rename(temp.name.c_str(), fileName) != 0)
+      return false;
+
+    // Make the rename itself durable as well.
+
+    const std::string path(fileName);
+    const std::string::size_type slash = path.rfind('/');
+    const std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+
+    const int fd = ::open(directory.c_str(), O_RDONLY);
+    if(fd >= 0) {
+      ::fsync(fd);
+      ::close(fd);
+    }
+
+    return true;
+  }
+
+#endif
+}  // namespace
+
 class File::FilePrivate
 {
 public:
   FilePrivate(IOStream *stream, bool owner) :
     stream(stream),
     streamOwner(owner),
-    valid(true) {}
+    valid(true),
+    searchBufferSize(64 * 1024),
+    minimumPadding(0),
+    maximumPadding(1024 * 1024),
+    paddingGrowthFactor(1.0),
+    paddingPolicySet(false) {}
 
   ~FilePrivate()
   {
@@ -83,6 +259,11 @@ public:
   IOStream *stream;
   bool streamOwner;
   bool valid;
+  unsigned int searchBufferSize;
+  unsigned int minimumPadding;
+  unsigned int maximumPadding;
+  double paddingGrowthFactor;
+  bool paddingPolicySet;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -222,6 +403,82 @@ PropertyMap File::setProperties(const PropertyMap &properties)
   return tag()->setProperties(properties);
 }
 
+bool File::saveAtomically()
+{
+  FileStream *const stream = dynamic_cast<FileStream *>(d->stream);
+
+#ifdef _WIN32
+  const FileName fileName(stream ? stream->name() : FileName(""));
+  const bool hasName = !fileName.wstr().empty();
+#else
+  const std::string path(stream ? resolvePath(stream->name()) : "");
+  const FileName fileName = path.c_str();
+  const bool hasName = !path.empty();
+#endif
+
+  if(!hasName) {
+    debug("File::saveAtomically() -- Only files opened by name can be saved atomically.");
+    return false;
+  }
+
+  if(readOnly()) {
+    debug("File::saveAtomically() -- File is read only.");
+    return false;
+  }
+
+  // Let the concrete subclass save as usual, but into an overlay of the file
+  // which only records the modifications.
+
+  OverlayStream overlay(stream);
+  d->stream = &overlay;
+  const bool saved = save();
+  d->stream = stream;
+
+  if(!saved)
+    return false;
+
+  if(!overlay.isModified())
+    return true;
+
+  TempFile temp;
+  if(!createTempFile(fileName, temp)) {
+    debug("File::saveAtomically() -- Could not create a temporary file.");
+    return false;
+  }
+
+  // Write the new contents out in one sequential pass.
+
+  bool written = true;
+
+  overlay.seek(0);
+  while(written) {
+    const ByteVector data = overlay.readBlock(1024 * 1024);
+    if(data.isEmpty())
+      break;
+
+    written = writeTempFile(temp, data);
+  }
+
+  if(!written || !closeTempFile(temp)) {
+    debug("File::saveAtomically() -- Could not write the temporary file.");
+    removeTempFile(temp);
+    return false;
+  }
+
+  // Windows can not replace a file which is still open.
+
+  stream->close();
+
+  const bool replaced = replaceFile(temp, fileName);
+  if(!replaced) {
+    debug("File::saveAtomically() -- Could not replace the file.");
+    removeTempFile(temp);
+  }
+
+  stream->reopen();
+  return replaced;
+}
+
 ByteVector File::readBlock(unsigned long length)
 {
   return d->stream->readBlock(length);
@@ -234,172 +491,220 @@ void File::writeBlock(const ByteVector &data)
 
 long File::find(const ByteVector &pattern, long fromOffset, const ByteVector &before)
 {
-  if(!d->stream || pattern.size() > bufferSize())
-      return -1;
+  return find(pattern, fromOffset, before, -1);
+}
+
+long File::find(const ByteVector &pattern, long fromOffset, const ByteVector &before,
+                long limitOffset)
+{
+  if(!d->stream || pattern.isEmpty() || fromOffset < 0)
+    return -1;
+
+  // The buffer holds the data read in the current iteration, preceded by the
+  // last bytes of the previous one which could be the beginning of a match
+  // that straddles the boundary.  Matches which lie entirely inside the kept
+  // bytes have already been ruled out.
 
-  // The position in the file that the current buffer starts at.
+  const unsigned int overlap = std::max(pattern.size(), before.size()) - 1;
+
+  // Start with a small read, since many patterns are found close to the
+  // starting point, and grow the reads up to the configured size while the
+  // search goes on.
+
+  unsigned long readLength = std::min(bufferSize(), d->searchBufferSize);
 
   long bufferOffset = fromOffset;
+  long readOffset = fromOffset;
   ByteVector buffer;
 
-  // These variables are used to keep track of a partial match that happens at
-  // the end of a buffer.
-
-  int previousPartialMatch = -1;
-  int beforePreviousPartialMatch = -1;
+  long location = -1;
 
   // Save the location of the current read pointer.  We will restore the
   // position using seek() before all returns.
 
-  long originalPosition = tell();
-
-  // Start the search at the offset.
-
-  seek(fromOffset);
-
-  // This loop is the crux of the find method.  There are three cases that we
-  // want to account for:
-  //
-  // (1) The previously searched buffer contained a partial match of the search
-  // pattern and we want to see if the next one starts with the remainder of
-  // that pattern.
-  //
-  // (2) The search pattern is wholly contained within the current buffer.
-  //
-  // (3) The current buffer ends with a partial match of the pattern.  We will
-  // note this for use in the next iteration, where we will check for the rest
-  // of the pattern.
-  //
-  // All three of these are done in two steps.  First we check for the pattern
-  // and do things appropriately if a match (or partial match) is found.  We
-  // then check for "before".  The order is important because it gives priority
-  // to "real" matches.
-
-  for(buffer = readBlock(bufferSize()); buffer.size() > 0; buffer = readBlock(bufferSize())) {
-
-    // (1) previous partial match
-
-    if(previousPartialMatch >= 0 && int(bufferSize()) > previousPartialMatch) {
-      const int patternOffset = (bufferSize() - previousPartialMatch);
-      if(buffer.containsAt(pattern, 0, patternOffset)) {
-        seek(originalPosition);
-        return bufferOffset - bufferSize() + previousPartialMatch;
-      }
-    }
+  const long originalPosition = tell();
 
-    if(!before.isEmpty() && beforePreviousPartialMatch >= 0 && int(bufferSize()) > beforePreviousPartialMatch) {
-      const int beforeOffset = (bufferSize() - beforePreviousPartialMatch);
-      if(buffer.containsAt(before, 0, beforeOffset)) {
-        seek(originalPosition);
-        return -1;
-      }
-    }
+  while(limitOffset < 0 || readOffset < limitOffset) {
 
-    // (2) pattern contained in current buffer
+    unsigned long length = readLength;
+    if(limitOffset >= 0)
+      length = std::min<unsigned long>(length, limitOffset - readOffset);
 
-    long location = buffer.find(pattern);
-    if(location >= 0) {
-      seek(originalPosition);
-      return bufferOffset + location;
-    }
+    seek(readOffset);
+    const ByteVector data = readBlock(length);
+    if(data.isEmpty())
+      break;
 
-    if(!before.isEmpty() && buffer.find(before) >= 0) {
-      seek(originalPosition);
-      return -1;
-    }
+    buffer.append(data);
+    readOffset += data.size();
 
-    // (3) partial match
+    const int patternIndex = buffer.find(pattern);
+    const int beforeIndex  = before.isEmpty() ? -1 : buffer.find(before);
 
-    previousPartialMatch = buffer.endsWithPartialMatch(pattern);
+    if(beforeIndex >= 0 && (patternIndex < 0 || beforeIndex < patternIndex))
+      break;
 
-    if(!before.isEmpty())
-      beforePreviousPartialMatch = buffer.endsWithPartialMatch(before);
+    if(patternIndex >= 0) {
+      location = bufferOffset + patternIndex;
+      break;
+    }
 
-    bufferOffset += bufferSize();
-  }
+    // Since we hit the end of the file, reset the status before continuing.
 
-  // Since we hit the end of the file, reset the status before continuing.
+    if(data.size() < length) {
+      clear();
+      break;
+    }
 
-  clear();
+    if(buffer.size() > overlap) {
+      bufferOffset += buffer.size() - overlap;
+      buffer = buffer.mid(buffer.size() - overlap);
+    }
+
+    readLength = std::min<unsigned long>(readLength * 2, d->searchBufferSize);
+  }
 
   seek(originalPosition);
 
-  return -1;
+  return location;
 }
 
-
 long File::rfind(const ByteVector &pattern, long fromOffset, const ByteVector &before)
 {
-  if(!d->stream || pattern.size() > bufferSize())
-      return -1;
+  return rfind(pattern, fromOffset, before, -1);
+}
 
-  // The position in the file that the current buffer starts at.
+long File::rfind(const ByteVector &pattern, long fromOffset, const ByteVector &before,
+                 long limitOffset)
+{
+  if(!d->stream || pattern.isEmpty() || fromOffset < 0)
+    return -1;
 
-  ByteVector buffer;
+  // See the notes in find() for an explanation of this algorithm.  Here the
+  // kept bytes are the first ones of the previous buffer, since we are going
+  // backwards.
 
-  // These variables are used to keep track of a partial match that happens at
-  // the end of a buffer.
+  const unsigned int overlap = std::max(pattern.size(), before.size()) - 1;
 
-  /*
-  int previousPartialMatch = -1;
-  int beforePreviousPartialMatch = -1;
-  */
+  unsigned long readLength = std::min(bufferSize(), d->searchBufferSize);
 
-  // Save the location of the current read pointer.  We will restore the
-  // position using seek() before all returns.
+  // Start the search at the offset.  A match may start at fromOffset, so the
+  // first buffer ends at the end of such a match.
 
-  long originalPosition = tell();
+  const long fileLength = length();
 
-  // Start the search at the offset.
+  long bufferEnd = fileLength;
+  if(fromOffset != 0)
+    bufferEnd = std::min<long>(fromOffset + pattern.size(), fileLength);
 
-  if(fromOffset == 0)
-    fromOffset = length();
+  const long startOffset = std::max<long>(limitOffset, 0);
 
-  long bufferLength = bufferSize();
-  long bufferOffset = fromOffset + pattern.size();
+  ByteVector buffer;
 
-  // See the notes in find() for an explanation of this algorithm.
+  long location = -1;
 
-  while(true) {
+  const long originalPosition = tell();
 
-    if(bufferOffset > bufferLength) {
-      bufferOffset -= bufferLength;
-    }
-    else {
-      bufferLength = bufferOffset;
-      bufferOffset = 0;
-    }
-    seek(bufferOffset);
+  while(bufferEnd > startOffset) {
+
+    const unsigned long length = std::min<unsigned long>(readLength, bufferEnd - startOffset);
+    const long readOffset = bufferEnd - length;
 
-    buffer = readBlock(bufferLength);
-    if(buffer.isEmpty())
+    seek(readOffset);
+    ByteVector data = readBlock(length);
+    if(data.isEmpty())
       break;
 
-    // TODO: (1) previous partial match
+    buffer = data.append(buffer);
 
-    // (2) pattern contained in current buffer
+    const int patternIndex = buffer.rfind(pattern);
+    const int beforeIndex  = before.isEmpty() ? -1 : buffer.rfind(before);
 
-    const long location = buffer.rfind(pattern);
-    if(location >= 0) {
-      seek(originalPosition);
-      return bufferOffset + location;
-    }
+    if(beforeIndex >= 0 && (patternIndex < 0 || beforeIndex > patternIndex))
+      break;
 
-    if(!before.isEmpty() && buffer.find(before) >= 0) {
-      seek(originalPosition);
-      return -1;
+    if(patternIndex >= 0) {
+      location = readOffset + patternIndex;
+      break;
     }
 
-    // TODO: (3) partial match
-  }
+    buffer = buffer.mid(0, overlap);
+    bufferEnd = readOffset;
 
-  // Since we hit the end of the file, reset the status before continuing.
+    readLength = std::min<unsigned long>(readLength * 2, d->searchBufferSize);
+  }
 
   clear();
 
   seek(originalPosition);
 
-  return -1;
+  return location;
+}
+
+unsigned int File::searchBufferSize() const
+{
+  return d->searchBufferSize;
+}
+
+void File::setSearchBufferSize(unsigned int size)
+{
+  d->searchBufferSize = std::max(size, 1U);
+}
+
+void File::setPaddingPolicy(unsigned int minimum, unsigned int maximum, double growthFactor)
+{
+  d->minimumPadding = minimum;
+  d->maximumPadding = std::max(minimum, maximum);
+  d->paddingGrowthFactor = std::max(growthFactor, 1.0);
+  d->paddingPolicySet = true;
+}
+
+unsigned int File::minimumPadding() const
+{
+  return d->minimumPadding;
+}
+
+unsigned int File::maximumPadding() const
+{
+  return d->maximumPadding;
+}
+
+double File::paddingGrowthFactor() const
+{
+  return d->paddingGrowthFactor;
+}
+
+bool File::hasPaddingPolicy() const
+{
+  return d->paddingPolicySet;
+}
+
+long File::paddingSize(long availableSize, long tagSize, long defaultMinimum) const
+{
+  const long minimum = (d->minimumPadding > 0) ? static_cast<long>(d->minimumPadding) : defaultMinimum;
+  const long maximum = std::max(static_cast<long>(d->maximumPadding), minimum);
+
+  // The headroom which is reserved for a tag of the given size.
+
+  const double growthFactor = d->paddingGrowthFactor;
+  const long growth = std::min(std::max(static_cast<long>(tagSize * (growthFactor - 1.0)), minimum), maximum);
+
+  const long spare = availableSize - tagSize;
+  if(spare < 0)
+    return growth;
+
+  // Keep the existing padding, so that nothing has to be moved, unless it is
+  // more than 1% of the file and more than the policy would have reserved
+  // for the space it is in.
+
+  long threshold = std::min(d->stream->length() / 100, maximum);
+  threshold = std::max(threshold, minimum);
+  threshold = std::max(threshold, std::min(static_cast<long>(availableSize * (growthFactor - 1.0)), maximum));
+
+  if(spare > threshold)
+    return growth;
+
+  return spare;
 }
 
 void File::insert(const ByteVector &data, unsigned long start, unsigned long replace)
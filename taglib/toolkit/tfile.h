@@ -79,6 +79,25 @@ namespace TagLib {
       DoNotDuplicate //<! Do not synchronize values between different tag types
     };
 
+    /*!
+     * Specifies which parts of a file are read when it is opened.  The values
+     * can be combined with the | operator.  Formats which support it only
+     * touch the regions of the file which are needed for the requested parts.
+     *
+     * A file which has been opened without all of its tags and pictures can
+     * not be saved, since the parts which have not been read would be lost.
+     */
+    enum ReadParts {
+      //! Read the tags.
+      ReadTags       = 0x01,
+      //! Read the embedded pictures.
+      ReadPictures   = 0x02,
+      //! Read the audio properties.
+      ReadProperties = 0x04,
+      //! Read everything.
+      ReadAll        = ReadTags | ReadPictures | ReadProperties
+    };
+
     /*!
      * Destroys this File instance.
      */
@@ -152,6 +171,27 @@ namespace TagLib {
      */
     virtual bool save() = 0;
 
+    /*!
+     * Saves the file like save() does, but never modifies the file in place.
+     * The new contents are written to a temporary file next to the original
+     * one, which is flushed to disk and then renamed over the original file.
+     * So the file contains either the old or the new contents, even if the
+     * process or the system crashes while saving.  Returns true if the save
+     * succeeds.
+     *
+     * This is only possible if the file is backed by a FileStream which was
+     * opened by its name.  Other streams are not supported.
+     *
+     * \note The new file gets the permissions and, as far as the process is
+     * allowed to change it, the owner of the original file.  On UNIX, a
+     * symbolic link is followed and its target is replaced.  On Windows, the
+     * link itself is replaced.  Other attributes, such as extended attributes
+     * or further hard links to the file, are not preserved.
+     *
+     * \see save()
+     */
+    bool saveAtomically();
+
     /*!
      * Reads a block of size \a length at the current get pointer.
      */
@@ -177,13 +217,23 @@ namespace TagLib {
      * Searching starts at \a fromOffset, which defaults to the beginning of the
      * file.
      *
-     * \note This has the practical limitation that \a pattern can not be longer
-     * than the buffer size used by readBlock().  Currently this is 1024 bytes.
+     * \see searchBufferSize()
      */
     long find(const ByteVector &pattern,
               long fromOffset = 0,
               const ByteVector &before = ByteVector());
 
+    /*!
+     * Returns the offset in the file that \a pattern occurs at or -1 if it can
+     * not be found.  This works like the above, but only matches which end at
+     * or before \a limitOffset are considered, so no data beyond it is read.
+     * A negative \a limitOffset searches to the end of the file.
+     */
+    long find(const ByteVector &pattern,
+              long fromOffset,
+              const ByteVector &before,
+              long limitOffset);
+
     /*!
      * Returns the offset in the file that \a pattern occurs at or -1 if it can
      * not be found.  If \a before is set, the search will only continue until the
@@ -193,13 +243,96 @@ namespace TagLib {
      * Searching starts at \a fromOffset and proceeds from the that point to the
      * beginning of the file and defaults to the end of the file.
      *
-     * \note This has the practical limitation that \a pattern can not be longer
-     * than the buffer size used by readBlock().  Currently this is 1024 bytes.
+     * \see searchBufferSize()
      */
     long rfind(const ByteVector &pattern,
                long fromOffset = 0,
                const ByteVector &before = ByteVector());
 
+    /*!
+     * Returns the offset in the file that \a pattern occurs at or -1 if it can
+     * not be found.  This works like the above, but only matches which start at
+     * or after \a limitOffset are considered, so no data in front of it is read.
+     * A negative \a limitOffset searches to the beginning of the file.
+     */
+    long rfind(const ByteVector &pattern,
+               long fromOffset,
+               const ByteVector &before,
+               long limitOffset);
+
+    /*!
+     * Returns the maximum size of the reads done by find() and rfind().
+     *
+     * The searches start with small reads, since the pattern is often close to
+     * the starting point, and double the size of each read up to this value.
+     * The default is 64 KiB.
+     *
+     * \see setSearchBufferSize()
+     */
+    unsigned int searchBufferSize() const;
+
+    /*!
+     * Sets the maximum size of the reads done by find() and rfind() to \a size.
+     * Larger values mean fewer reads when large parts of a file have to be
+     * searched, at the cost of memory.
+     *
+     * \see searchBufferSize()
+     */
+    void setSearchBufferSize(unsigned int size);
+
+    /*!
+     * Sets the policy for the padding which is reserved behind the tags of
+     * the formats that support it, i.e. ID3v2, FLAC metadata and MP4.
+     *
+     * If a saved tag still fits into the space of the old one and its
+     * padding, the rest of that space is kept as padding and the tag is
+     * overwritten in place, so the audio data does not have to be moved.  If
+     * the tag does not fit, it is given \a growthFactor times its size, but
+     * at least \a minimum and at most \a maximum bytes, to grow into.  Padding
+     * beyond 1% of the file size, \a maximum and the amount reserved on growth
+     * is given back.
+     *
+     * A \a minimum of 0 means the default of the format: 1 KiB for ID3v2,
+     * 4 KiB for FLAC and up to the next 1 KiB boundary for MP4.  The default
+     * policy is (0, 1 MiB, 1.0), except that MP4 files keep all of their
+     * padding unless a policy has been set, since giving it back moves the
+     * media data.
+     *
+     * \see paddingSize()
+     */
+    void setPaddingPolicy(unsigned int minimum, unsigned int maximum, double growthFactor);
+
+    /*!
+     * Returns the minimum padding set by setPaddingPolicy().
+     */
+    unsigned int minimumPadding() const;
+
+    /*!
+     * Returns the maximum padding set by setPaddingPolicy().
+     */
+    unsigned int maximumPadding() const;
+
+    /*!
+     * Returns the padding growth factor set by setPaddingPolicy().
+     */
+    double paddingGrowthFactor() const;
+
+    /*!
+     * Returns true if a padding policy has been set with setPaddingPolicy().
+     * Formats which never shrink their padding by default only follow the
+     * policy in this case.
+     */
+    bool hasPaddingPolicy() const;
+
+    /*!
+     * Returns the amount of padding to write behind a tag of \a tagSize bytes
+     * which replaces \a availableSize bytes of the file, according to the
+     * padding policy.  \a defaultMinimum is the minimum padding of the format.
+     *
+     * \see setPaddingPolicy()
+     */
+    long paddingSize(long availableSize, long tagSize, long defaultMinimum) const;
+
     /*!
      * Insert \a data at position \a start in the file overwriting \a replace
      * bytes of the original content.
@@ -318,6 +451,14 @@ namespace TagLib {
     FilePrivate *d;
   };
 
+  /*!
+   * Combines two sets of parts to read.
+   */
+  inline File::ReadParts operator|(File::ReadParts a, File::ReadParts b)
+  {
+    return File::ReadParts(static_cast<int>(a) | static_cast<int>(b));
+  }
+
 }
 
 #endif
@@ -23,6 +23,12 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <algorithm>
+
 #include "tfilestream.h"
 #include "tstring.h"
 #include "tdebug.h"
@@ -30,8 +36,10 @@
 #ifdef _WIN32
 # include <windows.h>
 #else
-# include <stdio.h>
+# include <errno.h>
+# include <fcntl.h>
 # include <unistd.h>
+# include <sys/stat.h>
 #endif
 
 using namespace TagLib;
@@ -94,33 +102,96 @@ namespace
     operator FileName () const { return c_str(); }
   };
 
-  typedef FILE* FileHandle;
+  // Uses positional I/O on a raw file descriptor instead of stdio.  The file
+  // position is tracked here, so seeking costs no system call and reads are
+  // not bounced through a stdio buffer which is discarded on every seek.
+
+  struct PosixFile
+  {
+    PosixFile(int fd, long position) : fd(fd), position(position) {}
+
+    int fd;
+    long position;
+  };
+
+  typedef PosixFile* FileHandle;
 
   const FileHandle InvalidFileHandle = 0;
 
   FileHandle openFile(const FileName &path, bool readOnly)
   {
-    return fopen(path, readOnly ? "rb" : "rb+");
+    const int fd = ::open(path, readOnly ? O_RDONLY : O_RDWR);
+    if(fd < 0)
+      return InvalidFileHandle;
+
+    return new PosixFile(fd, 0);
   }
 
   FileHandle openFile(const int fileDescriptor, bool readOnly)
   {
-    return fdopen(fileDescriptor, readOnly ? "rb" : "rb+");
+    const int flags = ::fcntl(fileDescriptor, F_GETFL);
+    if(flags < 0)
+      return InvalidFileHandle;
+
+    const int mode = flags & O_ACCMODE;
+    if(readOnly ? (mode == O_WRONLY) : (mode != O_RDWR))
+      return InvalidFileHandle;
+
+    // Start at the current offset of the descriptor like fdopen() does.
+
+    const off_t position = ::lseek(fileDescriptor, 0, SEEK_CUR);
+    return new PosixFile(fileDescriptor, position > 0 ? static_cast<long>(position) : 0);
   }
 
   void closeFile(FileHandle file)
   {
-    fclose(file);
+    ::close(file->fd);
+    delete file;
   }
 
   size_t readFile(FileHandle file, ByteVector &buffer)
   {
-    return fread(buffer.data(), sizeof(char), buffer.size(), file);
+    size_t count = 0;
+    while(count < buffer.size()) {
+      const ssize_t n = ::pread(file->fd, buffer.data() + count, buffer.size() - count,
+                                static_cast<off_t>(file->position + count));
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        break;
+
+      count += static_cast<size_t>(n);
+    }
+
+    file->position += static_cast<long>(count);
+    return count;
   }
 
   size_t writeFile(FileHandle file, const ByteVector &buffer)
   {
-    return fwrite(buffer.data(), sizeof(char), buffer.size(), file);
+    size_t count = 0;
+    while(count < buffer.size()) {
+      const ssize_t n = ::pwrite(file->fd, buffer.data() + count, buffer.size() - count,
+                                 static_cast<off_t>(file->position + count));
+      if(n < 0 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        break;
+
+      count += static_cast<size_t>(n);
+    }
+
+    file->position += static_cast<long>(count);
+    return count;
+  }
+
+  long fileLength(FileHandle file)
+  {
+    struct stat st;
+    if(::fstat(file->fd, &st) != 0)
+      return -1;
+
+    return static_cast<long>(st.st_size);
   }
 
 #endif  // _WIN32
@@ -133,12 +204,14 @@ public:
     : file(InvalidFileHandle)
     , name(fileName)
     , readOnly(true)
+    , copyBufferSize(1024 * 1024)
   {
   }
 
   FileHandle file;
   FileNameHandle name;
   bool readOnly;
+  unsigned int copyBufferSize;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -206,9 +279,11 @@ ByteVector FileStream::readBlock(unsigned long length)
   if(length == 0)
     return ByteVector();
 
-  const unsigned long streamLength = static_cast<unsigned long>(FileStream::length());
-  if(length > bufferSize() && length > streamLength)
-    length = streamLength;
+  if(length > bufferSize()) {
+    const unsigned long streamLength = static_cast<unsigned long>(FileStream::length());
+    if(length > streamLength)
+      length = streamLength;
+  }
 
   ByteVector buffer(static_cast<unsigned int>(length));
 
@@ -257,61 +332,18 @@ void FileStream::insert(const ByteVector &data, unsigned long start, unsigned lo
     return;
   }
 
-  // Woohoo!  Faster (about 20%) than id3lib at last.  I had to get hardcore
-  // and avoid TagLib's high level API for rendering just copying parts of
-  // the file that don't contain tag data.
-  //
-  // Now I'll explain the steps in this ugliness:
-
-  // First, make sure that we're working with a buffer that is longer than
-  // the *difference* in the tag sizes.  We want to avoid overwriting parts
-  // that aren't yet in memory, so this is necessary.
-
-  unsigned long bufferLength = bufferSize();
-
-  while(data.size() - replace > bufferLength)
-    bufferLength += bufferSize();
-
-  // Set where to start the reading and writing.
-
-  long readPosition = start + replace;
-  long writePosition = start;
-
-  ByteVector buffer = data;
-  ByteVector aboutToOverwrite(static_cast<unsigned int>(bufferLength));
-
-  while(true) {
-    // Seek to the current read position and read the data that we're about
-    // to overwrite.  Appropriately increment the readPosition.
-
-    seek(readPosition);
-    const unsigned int bytesRead = static_cast<unsigned int>(readFile(d->file, aboutToOverwrite));
-    aboutToOverwrite.resize(bytesRead);
-    readPosition += bufferLength;
-
-    // Check to see if we just read the last block.  We need to call clear()
-    // if we did so that the last write succeeds.
+  // Move everything behind the replaced part towards the end of the file to
+  // make room for the new data, then write the new data into the gap.
 
-    if(bytesRead < bufferLength)
-      clear();
-
-    // Seek to the write position and write our buffer.  Increment the
-    // writePosition.
-
-    seek(writePosition);
-    writeBlock(buffer);
+  const long fileLength = length();
+  const long readPosition = start + replace;
+  const long writePosition = start + data.size();
 
-    // We hit the end of the file.
+  if(readPosition < fileLength)
+    moveBlock(readPosition, writePosition, fileLength - readPosition);
 
-    if(bytesRead == 0)
-      break;
-
-    writePosition += buffer.size();
-
-    // Make the current buffer the data that we read in the beginning.
-
-    buffer = aboutToOverwrite;
-  }
+  seek(start);
+  writeBlock(data);
 }
 
 void FileStream::removeBlock(unsigned long start, unsigned long length)
@@ -321,33 +353,17 @@ void FileStream::removeBlock(unsigned long start, unsigned long length)
     return;
   }
 
-  unsigned long bufferLength = bufferSize();
-
-  long readPosition = start + length;
-  long writePosition = start;
-
-  ByteVector buffer(static_cast<unsigned int>(bufferLength));
-
-  for(unsigned int bytesRead = -1; bytesRead != 0;) {
-    seek(readPosition);
-    bytesRead = static_cast<unsigned int>(readFile(d->file, buffer));
-    readPosition += bytesRead;
-
-    // Check to see if we just read the last block.  We need to call clear()
-    // if we did so that the last write succeeds.
-
-    if(bytesRead < buffer.size()) {
-      clear();
-      buffer.resize(bytesRead);
-    }
+  const long fileLength = FileStream::length();
+  const long readPosition = start + length;
 
-    seek(writePosition);
-    writeFile(d->file, buffer);
-
-    writePosition += bytesRead;
+  if(readPosition >= fileLength) {
+    if(static_cast<long>(start) < fileLength)
+      truncate(start);
+    return;
   }
 
-  truncate(writePosition);
+  moveBlock(readPosition, start, fileLength - readPosition);
+  truncate(fileLength - length);
 }
 
 bool FileStream::readOnly() const
@@ -383,38 +399,38 @@ void FileStream::seek(long offset, Position p)
 
 #else
 
-  int whence;
+  long position;
   switch(p) {
   case Beginning:
-    whence = SEEK_SET;
+    position = offset;
     break;
   case Current:
-    whence = SEEK_CUR;
+    position = d->file->position + offset;
     break;
   case End:
-    whence = SEEK_END;
+    position = fileLength(d->file) + offset;
     break;
   default:
     debug("FileStream::seek() -- Invalid Position value.");
     return;
   }
 
-  fseek(d->file, offset, whence);
+  // Like fseek(), refuse to move in front of the beginning of the file, but
+  // allow to move past its end.
+
+  if(position < 0) {
+    debug("FileStream::seek() -- Invalid offset.");
+    return;
+  }
+
+  d->file->position = position;
 
 #endif
 }
 
 void FileStream::clear()
 {
-#ifdef _WIN32
-
-  // NOP
-
-#else
-
-  clearerr(d->file);
-
-#endif
+  // There is no FILE * error state left to clear.
 }
 
 long FileStream::tell() const
@@ -435,7 +451,7 @@ long FileStream::tell() const
 
 #else
 
-  return ftell(d->file);
+  return d->file->position;
 
 #endif
 }
@@ -461,16 +477,27 @@ long FileStream::length()
 
 #else
 
-  const long curpos = tell();
+  const long fileSize = fileLength(d->file);
 
-  seek(0, End);
-  const long endpos = tell();
+  if(fileSize >= 0) {
+    return fileSize;
+  }
+  else {
+    debug("FileStream::length() -- Failed to get the file size.");
+    return 0;
+  }
 
-  seek(curpos, Beginning);
+#endif
+}
 
-  return endpos;
+unsigned int FileStream::copyBufferSize() const
+{
+  return d->copyBufferSize;
+}
 
-#endif
+void FileStream::setCopyBufferSize(unsigned int size)
+{
+  d->copyBufferSize = std::max(size, bufferSize());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -493,8 +520,7 @@ void FileStream::truncate(long length)
 
 #else
 
-  fflush(d->file);
-  const int error = ftruncate(fileno(d->file), length);
+  const int error = ftruncate(d->file->fd, length);
   if(error != 0)
     debug("FileStream::truncate() -- Couldn't truncate the file.");
 
@@ -505,3 +531,113 @@ unsigned int FileStream::bufferSize()
 {
   return 1024;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+void FileStream::close()
+{
+  if(isOpen()) {
+    closeFile(d->file);
+    d->file = InvalidFileHandle;
+  }
+}
+
+void FileStream::reopen()
+{
+  close();
+
+  d->file = openFile(d->name, d->readOnly);
+
+  if(d->file == InvalidFileHandle)
+# ifdef _WIN32
+    debug("Could not reopen file " + d->name.toString());
+# else
+    debug("Could not reopen file " + String(static_cast<const char *>(d->name)));
+# endif
+}
+
+void FileStream::moveBlock(long from, long to, long length)
+{
+  if(from == to || length <= 0)
+    return;
+
+  // When moving towards the end of the file, start with the last chunk so
+  // that no data is overwritten before it has been copied.  Each chunk is
+  // read completely before it is written, so chunks may overlap.
+
+  const bool backwards = (to > from);
+
+#ifdef HAVE_COPY_FILE_RANGE
+
+  // Let the kernel copy the data if the chunks do not overlap, which is
+  // required by copy_file_range().  Some file systems can even share the
+  // data blocks instead of copying them.  The buffered copy below takes over
+  // whatever could not be copied this way.
+
+  const long distance = backwards ? (to - from) : (from - to);
+
+  if(distance >= static_cast<long>(bufferSize())) {
+    const long chunkSize = std::min<long>(distance, d->copyBufferSize);
+
+    while(length > 0) {
+      const long chunk = std::min(chunkSize, length);
+      loff_t inOffset  = backwards ? (from + length - chunk) : from;
+      loff_t outOffset = backwards ? (to   + length - chunk) : to;
+
+      long copied = 0;
+      while(copied < chunk) {
+        const ssize_t count = ::copy_file_range(
+          d->file->fd, &inOffset, d->file->fd, &outOffset, static_cast<size_t>(chunk - copied), 0);
+        if(count < 0 && errno == EINTR)
+          continue;
+        if(count <= 0)
+          break;
+
+        copied += count;
+      }
+
+      // The source of an incomplete chunk is still intact, so the buffered
+      // copy can simply do it again.
+
+      if(copied < chunk)
+        break;
+
+      if(!backwards) {
+        from += chunk;
+        to   += chunk;
+      }
+      length -= chunk;
+    }
+  }
+
+#endif
+
+  ByteVector buffer(static_cast<unsigned int>(std::min<long>(length, d->copyBufferSize)));
+
+  while(length > 0) {
+    const long chunk = std::min<long>(length, d->copyBufferSize);
+    const long readPosition  = backwards ? (from + length - chunk) : from;
+    const long writePosition = backwards ? (to   + length - chunk) : to;
+
+    buffer.resize(static_cast<unsigned int>(chunk));
+
+    seek(readPosition);
+    const size_t bytesRead = readFile(d->file, buffer);
+    if(bytesRead < static_cast<size_t>(chunk)) {
+      debug("FileStream::moveBlock() -- Failed to read the data to move.");
+      clear();
+      return;
+    }
+
+    seek(writePosition);
+    writeFile(d->file, buffer);
+
+    if(!backwards) {
+      from += chunk;
+      to   += chunk;
+    }
+    length -= chunk;
+  }
+}
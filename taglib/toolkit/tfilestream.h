@@ -90,7 +90,8 @@ namespace TagLib {
      * bytes of the original content.
      *
      * \note This method is slow since it requires rewriting all of the file
-     * after the insertion point.
+     * after the insertion point.  The data is moved in chunks of
+     * copyBufferSize() bytes, and by the kernel where it is supported.
      */
     void insert(const ByteVector &data, unsigned long start = 0, unsigned long replace = 0);
 
@@ -142,6 +143,24 @@ namespace TagLib {
      */
     void truncate(long length);
 
+    /*!
+     * Returns the size of the buffer used to move the data behind the modified
+     * part of the file in insert() and removeBlock().  The default is 1 MiB.
+     *
+     * \see setCopyBufferSize()
+     */
+    unsigned int copyBufferSize() const;
+
+    /*!
+     * Sets the size of the buffer used to move the data behind the modified
+     * part of the file in insert() and removeBlock() to \a size.  Larger values
+     * mean fewer reads and writes when a tag at the beginning of a large file
+     * changes its size.
+     *
+     * \see copyBufferSize()
+     */
+    void setCopyBufferSize(unsigned int size);
+
   protected:
 
     /*!
@@ -150,6 +169,24 @@ namespace TagLib {
     static unsigned int bufferSize();
 
   private:
+    friend class File;
+
+    /*!
+     * Closes the file.  It can be opened again by its name with reopen(), e.g.
+     * after it has been replaced by File::saveAtomically().
+     */
+    void close();
+
+    /*!
+     * Opens the file by its name again.
+     */
+    void reopen();
+
+    /*!
+     * Moves \a length bytes at \a from to \a to.  The ranges may overlap.
+     */
+    void moveBlock(long from, long to, long length);
+
     class FileStreamPrivate;
     FileStreamPrivate *d;
   };
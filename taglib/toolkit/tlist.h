@@ -28,14 +28,14 @@
 
 #include "taglib.h"
 
-#include <list>
+#include <vector>
 
 namespace TagLib {
 
   //! A generic, implicitly shared list.
 
   /*!
-   * This is basic generic list that's somewhere between a std::list and a
+   * This is basic generic list that's somewhere between a std::vector and a
    * QValueList.  This class is implicitly shared.  For example:
    *
    * \code
@@ -48,14 +48,21 @@ namespace TagLib {
    * return types of functions.  The above example will just copy a pointer rather
    * than copying the data in the list.  When your \e shared list's data changes,
    * only \e then will the data be copied.
+   *
+   * The items are stored contiguously, so indexed access is constant time.
+   * As with std::vector, adding or removing items may invalidate iterators
+   * and references to the items of the list.
+   *
+   * \note Earlier versions stored the items in a std::list, whose
+   * iterators stay valid when other items are added or removed.
    */
 
   template <class T> class List
   {
   public:
 #ifndef DO_NOT_DOCUMENT
-    typedef typename std::list<T>::iterator Iterator;
-    typedef typename std::list<T>::const_iterator ConstIterator;
+    typedef typename std::vector<T>::iterator Iterator;
+    typedef typename std::vector<T>::const_iterator ConstIterator;
 #endif
 
     /*!
@@ -78,30 +85,31 @@ namespace TagLib {
 
     /*!
      * Returns an STL style iterator to the beginning of the list.  See
-     * std::list::const_iterator for the semantics.
+     * std::vector::const_iterator for the semantics.
      */
     Iterator begin();
 
     /*!
      * Returns an STL style constant iterator to the beginning of the list.  See
-     * std::list::iterator for the semantics.
+     * std::vector::iterator for the semantics.
      */
     ConstIterator begin() const;
 
     /*!
      * Returns an STL style iterator to the end of the list.  See
-     * std::list::iterator for the semantics.
+     * std::vector::iterator for the semantics.
      */
     Iterator end();
 
     /*!
      * Returns an STL style constant iterator to the end of the list.  See
-     * std::list::const_iterator for the semantics.
+     * std::vector::const_iterator for the semantics.
      */
     ConstIterator end() const;
 
     /*!
-     * Inserts a copy of \a value before \a it.
+     * Inserts a copy of \a value before \a it and returns an iterator to the
+     * inserted item.
      */
     Iterator insert(Iterator it, const T &value);
 
@@ -174,7 +182,8 @@ namespace TagLib {
     bool contains(const T &value) const;
 
     /*!
-     * Erase the item at \a it from the list.
+     * Erase the item at \a it from the list and returns an iterator to the
+     * item that followed it.
      */
     Iterator erase(Iterator it);
 
@@ -54,11 +54,11 @@ template <class TP> class List<T>::ListPrivate  : public ListPrivateBase
 {
 public:
   ListPrivate() : ListPrivateBase() {}
-  ListPrivate(const std::list<TP> &l) : ListPrivateBase(), list(l) {}
+  ListPrivate(const std::vector<TP> &l) : ListPrivateBase(), list(l) {}
   void clear() {
     list.clear();
   }
-  std::list<TP> list;
+  std::vector<TP> list;
 };
 
 // A partial specialization for all pointer types that implements the
@@ -69,19 +69,19 @@ template <class TP> class List<T>::ListPrivate<TP *>  : public ListPrivateBase
 {
 public:
   ListPrivate() : ListPrivateBase() {}
-  ListPrivate(const std::list<TP *> &l) : ListPrivateBase(), list(l) {}
+  ListPrivate(const std::vector<TP *> &l) : ListPrivateBase(), list(l) {}
   ~ListPrivate() {
     clear();
   }
   void clear() {
     if(autoDelete) {
-      typename std::list<TP *>::const_iterator it = list.begin();
+      typename std::vector<TP *>::const_iterator it = list.begin();
       for(; it != list.end(); ++it)
         delete *it;
     }
     list.clear();
   }
-  std::list<TP *> list;
+  std::vector<TP *> list;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -165,7 +165,16 @@ template <class T>
 List<T> &List<T>::append(const List<T> &l)
 {
   detach();
-  d->list.insert(d->list.end(), l.begin(), l.end());
+
+  // A vector must not insert a range of its own items.
+
+  if(&l == this) {
+    const std::vector<T> items(d->list);
+    d->list.insert(d->list.end(), items.begin(), items.end());
+  }
+  else {
+    d->list.insert(d->list.end(), l.begin(), l.end());
+  }
   return *this;
 }
 
@@ -173,7 +182,7 @@ template <class T>
 List<T> &List<T>::prepend(const T &item)
 {
   detach();
-  d->list.push_front(item);
+  d->list.insert(d->list.begin(), item);
   return *this;
 }
 
@@ -181,7 +190,16 @@ template <class T>
 List<T> &List<T>::prepend(const List<T> &l)
 {
   detach();
-  d->list.insert(d->list.begin(), l.begin(), l.end());
+
+  // A vector must not insert a range of its own items.
+
+  if(&l == this) {
+    const std::vector<T> items(d->list);
+    d->list.insert(d->list.begin(), items.begin(), items.end());
+  }
+  else {
+    d->list.insert(d->list.begin(), l.begin(), l.end());
+  }
   return *this;
 }
 
@@ -265,19 +283,13 @@ T &List<T>::back()
 template <class T>
 T &List<T>::operator[](unsigned int i)
 {
-  Iterator it = d->list.begin();
-  std::advance(it, i);
-
-  return *it;
+  return d->list[i];
 }
 
 template <class T>
 const T &List<T>::operator[](unsigned int i) const
 {
-  ConstIterator it = d->list.begin();
-  std::advance(it, i);
-
-  return *it;
+  return d->list[i];
 }
 
 template <class T>
@@ -0,0 +1,332 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "tmmapfilestream.h"
+#include "tfilestream.h"
+#include "tstring.h"
+#include "tdebug.h"
+
+#include <climits>
+
+#ifdef _WIN32
+# include <windows.h>
+#elif defined(HAVE_MMAP)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+using namespace TagLib;
+
+namespace
+{
+  // A read-only view of the whole file.  Returns false and leaves the output
+  // parameters untouched if the file can not be mapped, e.g. since it is
+  // empty or too large for the address space.
+
+#ifdef _WIN32
+
+  struct Mapping
+  {
+    Mapping() : handle(NULL) {}
+    HANDLE handle;
+  };
+
+  bool mapFile(const FileName &path, Mapping &mapping, const char *&data, size_t &size)
+  {
+#if defined (PLATFORM_WINRT)
+    return false;
+#else
+    // The file is opened by FileStream as well, so both read and write access
+    // have to be shared.
+
+    const HANDLE file = CreateFileW(path.wstr().c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || fileSize.QuadPart > LONG_MAX) {
+      CloseHandle(file);
+      return false;
+    }
+
+    const HANDLE handle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+
+    if(!handle)
+      return false;
+
+    const void *view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    if(!view) {
+      CloseHandle(handle);
+      return false;
+    }
+
+    mapping.handle = handle;
+    data = static_cast<const char *>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+#endif
+  }
+
+  void unmapFile(Mapping &mapping, const char *data, size_t)
+  {
+    UnmapViewOfFile(data);
+    CloseHandle(mapping.handle);
+    mapping.handle = NULL;
+  }
+
+#elif defined(HAVE_MMAP)
+
+  struct Mapping
+  {
+  };
+
+  bool mapFile(const FileName &path, Mapping &, const char *&data, size_t &size)
+  {
+    const int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+      return false;
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || st.st_size > LONG_MAX) {
+      ::close(fd);
+      return false;
+    }
+
+    void *view = ::mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed.
+
+    ::close(fd);
+
+    if(view == MAP_FAILED)
+      return false;
+
+    data = static_cast<const char *>(view);
+    size = static_cast<size_t>(st.st_size);
+    return true;
+  }
+
+  void unmapFile(Mapping &, const char *data, size_t size)
+  {
+    ::munmap(const_cast<char *>(data), size);
+  }
+
+#else
+
+  struct Mapping
+  {
+  };
+
+  bool mapFile(const FileName &, Mapping &, const char *&, size_t &)
+  {
+    return false;
+  }
+
+  void unmapFile(Mapping &, const char *, size_t)
+  {
+  }
+
+#endif
+}  // namespace
+
+class MmapFileStream::MmapFileStreamPrivate
+{
+public:
+  MmapFileStreamPrivate(FileName fileName, bool openReadOnly) :
+    stream(fileName, openReadOnly),
+    data(0),
+    size(0),
+    position(0)
+  {
+    if(stream.isOpen() && !mapFile(fileName, mapping, data, size))
+      data = 0;
+  }
+
+  ~MmapFileStreamPrivate()
+  {
+    unmap();
+  }
+
+  // Releases the mapping and hands the current position over to the
+  // underlying stream, which takes care of all the operations from then on.
+
+  void unmap()
+  {
+    if(!data)
+      return;
+
+    unmapFile(mapping, data, size);
+    data = 0;
+    size = 0;
+
+    stream.seek(position);
+  }
+
+  FileStream stream;
+  Mapping mapping;
+  const char *data;
+  size_t size;
+  long position;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+MmapFileStream::MmapFileStream(FileName fileName, bool openReadOnly) :
+  d(new MmapFileStreamPrivate(fileName, openReadOnly))
+{
+}
+
+MmapFileStream::~MmapFileStream()
+{
+  delete d;
+}
+
+FileName MmapFileStream::name() const
+{
+  return d->stream.name();
+}
+
+ByteVector MmapFileStream::readBlock(unsigned long length)
+{
+  if(!d->data)
+    return d->stream.readBlock(length);
+
+  if(length == 0 || d->position < 0 || static_cast<size_t>(d->position) >= d->size)
+    return ByteVector();
+
+  const size_t available = d->size - static_cast<size_t>(d->position);
+  if(length > available)
+    length = static_cast<unsigned long>(available);
+
+  const ByteVector buffer(d->data + d->position, static_cast<unsigned int>(length));
+  d->position += static_cast<long>(length);
+
+  return buffer;
+}
+
+void MmapFileStream::writeBlock(const ByteVector &data)
+{
+  d->unmap();
+  d->stream.writeBlock(data);
+}
+
+void MmapFileStream::insert(const ByteVector &data, unsigned long start, unsigned long replace)
+{
+  d->unmap();
+  d->stream.insert(data, start, replace);
+}
+
+void MmapFileStream::removeBlock(unsigned long start, unsigned long length)
+{
+  d->unmap();
+  d->stream.removeBlock(start, length);
+}
+
+bool MmapFileStream::readOnly() const
+{
+  return d->stream.readOnly();
+}
+
+bool MmapFileStream::isOpen() const
+{
+  return d->stream.isOpen();
+}
+
+bool MmapFileStream::isMapped() const
+{
+  return (d->data != 0);
+}
+
+void MmapFileStream::seek(long offset, Position p)
+{
+  if(!d->data) {
+    d->stream.seek(offset, p);
+    return;
+  }
+
+  long position;
+  switch(p) {
+  case Beginning:
+    position = offset;
+    break;
+  case Current:
+    position = d->position + offset;
+    break;
+  case End:
+    position = static_cast<long>(d->size) + offset;
+    break;
+  default:
+    debug("MmapFileStream::seek() -- Invalid Position value.");
+    return;
+  }
+
+  // Like fseek(), refuse to move in front of the beginning of the file, but
+  // allow to move past its end.
+
+  if(position < 0) {
+    debug("MmapFileStream::seek() -- Invalid offset.");
+    return;
+  }
+
+  d->position = position;
+}
+
+void MmapFileStream::clear()
+{
+  if(!d->data)
+    d->stream.clear();
+}
+
+long MmapFileStream::tell() const
+{
+  if(!d->data)
+    return d->stream.tell();
+
+  return d->position;
+}
+
+long MmapFileStream::length()
+{
+  if(!d->data)
+    return d->stream.length();
+
+  return static_cast<long>(d->size);
+}
+
+void MmapFileStream::truncate(long length)
+{
+  d->unmap();
+  d->stream.truncate(length);
+}
@@ -0,0 +1,157 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_MMAPFILESTREAM_H
+#define TAGLIB_MMAPFILESTREAM_H
+
+#include "taglib_export.h"
+#include "taglib.h"
+#include "tbytevector.h"
+#include "tiostream.h"
+
+namespace TagLib {
+
+  //! A file stream which reads through a memory mapping of the file
+
+  /*!
+   * This is a drop-in replacement for FileStream which maps the whole file
+   * into memory when it is opened.  Reading a block is then a plain copy out
+   * of the mapping and does not involve any system calls, which makes probing
+   * a large number of files considerably cheaper.
+   *
+   * If the file can not be mapped (e.g. it is empty or the platform does not
+   * support memory-mapped files), all the operations are passed through to a
+   * regular FileStream.  The mapping is also released as soon as the file is
+   * modified, so writing works exactly the same way as with FileStream.
+   *
+   * \warning The file must not be truncated by another process while it is
+   * mapped, since accessing pages beyond the new end of the file is fatal on
+   * most platforms.
+   */
+
+  class TAGLIB_EXPORT MmapFileStream : public IOStream
+  {
+  public:
+    /*!
+     * Construct a MmapFileStream object and opens the \a file.  \a file should
+     * be a C-string in the local file system encoding.
+     */
+    MmapFileStream(FileName file, bool openReadOnly = false);
+
+    /*!
+     * Destroys this MmapFileStream instance.
+     */
+    virtual ~MmapFileStream();
+
+    /*!
+     * Returns the file name in the local file system encoding.
+     */
+    FileName name() const;
+
+    /*!
+     * Reads a block of size \a length at the current get pointer.
+     */
+    ByteVector readBlock(unsigned long length);
+
+    /*!
+     * Attempts to write the block \a data at the current get pointer.  If the
+     * file is currently only opened read only -- i.e. readOnly() returns true --
+     * this attempts to reopen the file in read/write mode.
+     *
+     * \note This releases the memory mapping of the file.
+     */
+    void writeBlock(const ByteVector &data);
+
+    /*!
+     * Insert \a data at position \a start in the file overwriting \a replace
+     * bytes of the original content.
+     *
+     * \note This releases the memory mapping of the file.
+     */
+    void insert(const ByteVector &data, unsigned long start = 0, unsigned long replace = 0);
+
+    /*!
+     * Removes a block of the file starting a \a start and continuing for
+     * \a length bytes.
+     *
+     * \note This releases the memory mapping of the file.
+     */
+    void removeBlock(unsigned long start = 0, unsigned long length = 0);
+
+    /*!
+     * Returns true if the file is read only (or if the file can not be opened).
+     */
+    bool readOnly() const;
+
+    /*!
+     * Since the file can currently only be opened as an argument to the
+     * constructor (sort-of by design), this returns if that open succeeded.
+     */
+    bool isOpen() const;
+
+    /*!
+     * Returns true if the reads are currently served from a memory mapping of
+     * the file.
+     */
+    bool isMapped() const;
+
+    /*!
+     * Move the I/O pointer to \a offset in the file from position \a p.  This
+     * defaults to seeking from the beginning of the file.
+     *
+     * \see Position
+     */
+    void seek(long offset, Position p = Beginning);
+
+    /*!
+     * Reset the end-of-file and error flags on the file.
+     */
+    void clear();
+
+    /*!
+     * Returns the current offset within the file.
+     */
+    long tell() const;
+
+    /*!
+     * Returns the length of the file.
+     */
+    long length();
+
+    /*!
+     * Truncates the file to a \a length.
+     *
+     * \note This releases the memory mapping of the file.
+     */
+    void truncate(long length);
+
+  private:
+    class MmapFileStreamPrivate;
+    MmapFileStreamPrivate *d;
+  };
+
+}
+
+#endif
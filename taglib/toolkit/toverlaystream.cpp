@@ -0,0 +1,295 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <vector>
+#include <algorithm>
+
+#include "toverlaystream.h"
+#include "tstring.h"
+#include "tdebug.h"
+
+using namespace TagLib;
+
+namespace
+{
+  // A piece of the contents.  It is either a range of the underlying stream
+  // starting at offset, or a slice of data starting at offset.
+
+  struct Piece
+  {
+    Piece(long offset, long length) :
+      inStream(true),
+      offset(offset),
+      length(length) {}
+
+    Piece(const ByteVector &data, long offset, long length) :
+      inStream(false),
+      offset(offset),
+      length(length),
+      data(data) {}
+
+    bool inStream;
+    long offset;
+    long length;
+    ByteVector data;
+  };
+
+  typedef std::vector<Piece> PieceList;
+}
+
+class OverlayStream::OverlayStreamPrivate
+{
+public:
+  OverlayStreamPrivate(IOStream *stream) :
+    stream(stream),
+    position(0),
+    modified(false)
+  {
+    const long length = stream->length();
+    if(length > 0)
+      pieces.push_back(Piece(0, length));
+  }
+
+  long length() const
+  {
+    long length = 0;
+    for(PieceList::const_iterator it = pieces.begin(); it != pieces.end(); ++it)
+      length += it->length;
+
+    return length;
+  }
+
+  // Makes sure that a piece starts at the given position, which must not be
+  // behind the end, and returns its index.
+
+  size_t split(long position)
+  {
+    long start = 0;
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      if(position == start)
+        return i;
+
+      if(position < start + pieces[i].length) {
+        const long head = position - start;
+
+        Piece tail = pieces[i];
+        tail.offset += head;
+        tail.length -= head;
+        pieces[i].length = head;
+
+        pieces.insert(pieces.begin() + i + 1, tail);
+        return i + 1;
+      }
+
+      start += pieces[i].length;
+    }
+
+    return pieces.size();
+  }
+
+  // Replaces length bytes at start with data.  Anything between the current
+  // end and start is filled with zeros, like a file system would do.
+
+  void replace(long start, long length, const ByteVector &data)
+  {
+    const long currentLength = this->length();
+    if(start > currentLength) {
+      pieces.push_back(Piece(ByteVector(start - currentLength, '\0'), 0, start - currentLength));
+    }
+
+    const size_t first = split(start);
+    const size_t last = split(std::min(start + length, std::max(currentLength, start)));
+
+    pieces.erase(pieces.begin() + first, pieces.begin() + last);
+
+    if(!data.isEmpty())
+      pieces.insert(pieces.begin() + first, Piece(data, 0, data.size()));
+
+    modified = true;
+  }
+
+  IOStream *stream;
+  PieceList pieces;
+  long position;
+  bool modified;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+OverlayStream::OverlayStream(IOStream *stream) :
+  d(new OverlayStreamPrivate(stream))
+{
+}
+
+OverlayStream::~OverlayStream()
+{
+  delete d;
+}
+
+FileName OverlayStream::name() const
+{
+  return d->stream->name();
+}
+
+ByteVector OverlayStream::readBlock(unsigned long length)
+{
+  ByteVector buffer;
+
+  long start = 0;
+  for(PieceList::const_iterator it = d->pieces.begin(); it != d->pieces.end() && length > 0; ++it) {
+    const long end = start + it->length;
+
+    if(d->position < end) {
+      const long offset = d->position - start;
+      const long count = std::min<long>(static_cast<long>(length), it->length - offset);
+
+      if(it->inStream) {
+        d->stream->seek(it->offset + offset);
+        const ByteVector data = d->stream->readBlock(count);
+        buffer.append(data);
+        if(static_cast<long>(data.size()) < count) {
+          d->position += data.size();
+          break;
+        }
+      }
+      else {
+        buffer.append(it->data.mid(it->offset + offset, count));
+      }
+
+      d->position += count;
+      length -= count;
+    }
+
+    start = end;
+  }
+
+  return buffer;
+}
+
+void OverlayStream::writeBlock(const ByteVector &data)
+{
+  if(readOnly()) {
+    debug("OverlayStream::writeBlock() -- read only stream.");
+    return;
+  }
+
+  d->replace(d->position, data.size(), data);
+  d->position += data.size();
+}
+
+void OverlayStream::insert(const ByteVector &data, unsigned long start, unsigned long replace)
+{
+  if(readOnly()) {
+    debug("OverlayStream::insert() -- read only stream.");
+    return;
+  }
+
+  d->replace(start, replace, data);
+  d->position = start + data.size();
+}
+
+void OverlayStream::removeBlock(unsigned long start, unsigned long length)
+{
+  if(readOnly()) {
+    debug("OverlayStream::removeBlock() -- read only stream.");
+    return;
+  }
+
+  if(static_cast<long>(start) < d->length())
+    d->replace(start, length, ByteVector());
+
+  d->position = start;
+}
+
+bool OverlayStream::readOnly() const
+{
+  return d->stream->readOnly();
+}
+
+bool OverlayStream::isOpen() const
+{
+  return d->stream->isOpen();
+}
+
+void OverlayStream::seek(long offset, Position p)
+{
+  long position;
+  switch(p) {
+  case Beginning:
+    position = offset;
+    break;
+  case Current:
+    position = d->position + offset;
+    break;
+  case End:
+    position = length() + offset;
+    break;
+  default:
+    debug("OverlayStream::seek() -- Invalid Position value.");
+    return;
+  }
+
+  if(position < 0) {
+    debug("OverlayStream::seek() -- Invalid offset.");
+    return;
+  }
+
+  d->position = position;
+}
+
+void OverlayStream::clear()
+{
+}
+
+long OverlayStream::tell() const
+{
+  return d->position;
+}
+
+long OverlayStream::length()
+{
+  return d->length();
+}
+
+void OverlayStream::truncate(long length)
+{
+  if(readOnly()) {
+    debug("OverlayStream::truncate() -- read only stream.");
+    return;
+  }
+
+  const long currentLength = d->length();
+  if(length < currentLength)
+    d->replace(length, currentLength - length, ByteVector());
+  else if(length > currentLength)
+    d->replace(length, 0, ByteVector());
+}
+
+bool OverlayStream::isModified() const
+{
+  return d->modified;
+}
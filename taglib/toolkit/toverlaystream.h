@@ -0,0 +1,80 @@
+/***************************************************************************
+    copyright            : (C) 2026 by the TagLib developers
+    email                : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_OVERLAYSTREAM_H
+#define TAGLIB_OVERLAYSTREAM_H
+
+#include "tiostream.h"
+
+// THIS FILE IS NOT A PART OF THE TAGLIB API
+
+#ifndef DO_NOT_DOCUMENT  // tell Doxygen not to document this header
+
+namespace TagLib {
+
+  //! A stream which records modifications instead of applying them
+
+  /*!
+   * This stream presents the contents of another stream with all the
+   * modifications done through it applied, but never modifies the other
+   * stream.  The contents are kept as a list of pieces which refer either to
+   * ranges of the other stream or to data in memory, so inserting or removing
+   * data does not move anything.
+   */
+
+  class OverlayStream : public IOStream
+  {
+  public:
+    OverlayStream(IOStream *stream);
+    virtual ~OverlayStream();
+
+    FileName name() const;
+    ByteVector readBlock(unsigned long length);
+    void writeBlock(const ByteVector &data);
+    void insert(const ByteVector &data, unsigned long start = 0, unsigned long replace = 0);
+    void removeBlock(unsigned long start = 0, unsigned long length = 0);
+    bool readOnly() const;
+    bool isOpen() const;
+    void seek(long offset, Position p = Beginning);
+    void clear();
+    long tell() const;
+    long length();
+    void truncate(long length);
+
+    /*!
+     * Returns true if any modification has been done through this stream.
+     */
+    bool isModified() const;
+
+  private:
+    class OverlayStreamPrivate;
+    OverlayStreamPrivate *d;
+  };
+
+}
+
+#endif
+
+#endif
@@ -27,6 +27,105 @@
 #include "tpropertymap.h"
 using namespace TagLib;
 
+namespace
+{
+  // The well-known keys, sorted.  Keys which are found here share the data of
+  // the strings in knownKey(), so they are converted to upper case and stored
+  // only once.
+
+  const char *const knownKeys[] = {
+    "ACOUSTID_FINGERPRINT", "ACOUSTID_ID", "ALBUM", "ALBUMARTIST",
+    "ALBUMARTISTSORT", "ALBUMSORT", "ARTIST", "ARTISTS", "ARTISTSORT",
+    "ARTISTWEBPAGE", "ASIN", "AUDIOSOURCEWEBPAGE", "BARCODE", "BPM",
+    "CATALOGNUMBER", "COMMENT", "COMPILATION", "COMPOSER", "COMPOSERSORT",
+    "CONDUCTOR", "COPYRIGHT", "COPYRIGHTURL", "DATE", "DISCNUMBER",
+    "DISCSUBTITLE", "DJMIXER", "ENCODEDBY", "ENCODING", "ENCODINGTIME",
+    "ENGINEER", "FILETYPE", "FILEWEBPAGE", "GAPLESSPLAYBACK", "GENRE",
+    "GROUPING", "INITIALKEY", "INVOLVEDPEOPLE", "ISRC", "LABEL", "LANGUAGE",
+    "LENGTH", "LICENSE", "LYRICIST", "LYRICS", "MEDIA", "MIXER", "MOOD",
+    "MOVEMENTCOUNT", "MOVEMENTNAME", "MOVEMENTNUMBER",
+    "MUSICBRAINZ_ALBUMARTISTID", "MUSICBRAINZ_ALBUMID",
+    "MUSICBRAINZ_ALBUMSTATUS", "MUSICBRAINZ_ALBUMTYPE", "MUSICBRAINZ_ARTISTID",
+    "MUSICBRAINZ_RELEASEGROUPID", "MUSICBRAINZ_RELEASETRACKID",
+    "MUSICBRAINZ_TRACKID", "MUSICBRAINZ_WORKID", "MUSICIP_PUID",
+    "ORIGINALALBUM", "ORIGINALARTIST", "ORIGINALDATE", "ORIGINALFILENAME",
+    "ORIGINALLYRICIST", "OWNER", "PAYMENTWEBPAGE", "PODCAST",
+    "PODCASTCATEGORY", "PODCASTDESC", "PODCASTID", "PODCASTURL", "PRODUCER",
+    "PUBLISHERWEBPAGE", "RADIOSTATION", "RADIOSTATIONOWNER",
+    "RADIOSTATIONWEBPAGE", "RELEASECOUNTRY", "RELEASEDATE", "RELEASESTATUS",
+    "RELEASETYPE", "REMIXER", "SCRIPT", "SHOWSORT", "SHOWWORKMOVEMENT",
+    "SUBTITLE", "TAGGINGDATE", "TITLE", "TITLESORT", "TRACKNUMBER",
+    "TVEPISODE", "TVEPISODEID", "TVNETWORK", "TVSEASON", "TVSHOW", "WORK"
+  };
+
+  const size_t knownKeyCount = sizeof(knownKeys) / sizeof(knownKeys[0]);
+
+  inline wchar_t upper(wchar_t c)
+  {
+    return (c >= 'a' && c <= 'z') ? static_cast<wchar_t>(c + 'A' - 'a') : c;
+  }
+
+  // Returns the well-known key at index as a string.  The strings are created
+  // on first use rather than during static initialization.
+
+  const String &knownKey(size_t index)
+  {
+    static String keys[knownKeyCount];
+    if(keys[0].isEmpty()) {
+      for(size_t i = 0; i < knownKeyCount; ++i)
+        keys[i] = knownKeys[i];
+    }
+    return keys[index];
+  }
+
+  // Compares key converted to upper case with the upper case knownKey.
+
+  int compareUpper(const wchar_t *key, size_t keySize, const char *knownKey)
+  {
+    size_t i = 0;
+    for(; i < keySize && knownKey[i] != '\0'; ++i) {
+      const wchar_t c = upper(key[i]);
+      const wchar_t k = static_cast<unsigned char>(knownKey[i]);
+      if(c != k)
+        return c < k ? -1 : 1;
+    }
+
+    if(i == keySize && knownKey[i] == '\0')
+      return 0;
+    return i == keySize ? -1 : 1;
+  }
+
+  // Returns key in upper case, without allocating a new string if it is a
+  // well-known key or already in upper case.
+
+  String normalizeKey(const String &key)
+  {
+    const wchar_t *data = key.toCWString();
+    const size_t size = key.size();
+
+    size_t first = 0;
+    size_t last = knownKeyCount;
+
+    while(first < last) {
+      const size_t middle = (first + last) / 2;
+      const int result = compareUpper(data, size, knownKeys[middle]);
+      if(result == 0)
+        return knownKey(middle);
+      if(result < 0)
+        last = middle;
+      else
+        first = middle + 1;
+    }
+
+    for(size_t i = 0; i < size; ++i) {
+      if(data[i] >= 'a' && data[i] <= 'z')
+        return key.upper();
+    }
+
+    return key;
+  }
+}  // namespace
+
 
 PropertyMap::PropertyMap()
 {
@@ -39,8 +138,7 @@ PropertyMap::PropertyMap(const PropertyMap &m) : SimplePropertyMap(m), unsupport
 PropertyMap::PropertyMap(const SimplePropertyMap &m)
 {
   for(SimplePropertyMap::ConstIterator it = m.begin(); it != m.end(); ++it){
-    String key = it->first.upper();
-    if(!key.isEmpty())
+    if(!it->first.isEmpty())
       insert(it->first, it->second);
     else
       unsupported.append(it->first);
@@ -53,18 +151,18 @@ PropertyMap::~PropertyMap()
 
 bool PropertyMap::insert(const String &key, const StringList &values)
 {
-  String realKey = key.upper();
+  const String realKey = normalizeKey(key);
   Iterator result = SimplePropertyMap::find(realKey);
   if(result == end())
     SimplePropertyMap::insert(realKey, values);
   else
-    SimplePropertyMap::operator[](realKey).append(values);
+    result->second.append(values);
   return true;
 }
 
 bool PropertyMap::replace(const String &key, const StringList &values)
 {
-  String realKey = key.upper();
+  const String realKey = normalizeKey(key);
   SimplePropertyMap::erase(realKey);
   SimplePropertyMap::insert(realKey, values);
   return true;
@@ -72,17 +170,17 @@ bool PropertyMap::replace(const String &key, const StringList &values)
 
 PropertyMap::Iterator PropertyMap::find(const String &key)
 {
-  return SimplePropertyMap::find(key.upper());
+  return SimplePropertyMap::find(normalizeKey(key));
 }
 
 PropertyMap::ConstIterator PropertyMap::find(const String &key) const
 {
-  return SimplePropertyMap::find(key.upper());
+  return SimplePropertyMap::find(normalizeKey(key));
 }
 
 bool PropertyMap::contains(const String &key) const
 {
-  return SimplePropertyMap::contains(key.upper());
+  return SimplePropertyMap::contains(normalizeKey(key));
 }
 
 bool PropertyMap::contains(const PropertyMap &other) const
@@ -98,7 +196,7 @@ bool PropertyMap::contains(const PropertyMap &other) const
 
 PropertyMap &PropertyMap::erase(const String &key)
 {
-  SimplePropertyMap::erase(key.upper());
+  SimplePropertyMap::erase(normalizeKey(key));
   return *this;
 }
 
@@ -119,12 +217,12 @@ PropertyMap &PropertyMap::merge(const PropertyMap &other)
 
 const StringList &PropertyMap::operator[](const String &key) const
 {
-  return SimplePropertyMap::operator[](key.upper());
+  return SimplePropertyMap::operator[](normalizeKey(key));
 }
 
 StringList &PropertyMap::operator[](const String &key)
 {
-  return SimplePropertyMap::operator[](key.upper());
+  return SimplePropertyMap::operator[](normalizeKey(key));
 }
 
 bool PropertyMap::operator==(const PropertyMap &other) const
@@ -25,6 +25,7 @@
 
 #include <cerrno>
 #include <climits>
+#include <cstring>
 
 #include <utf8-cpp/checked.h>
 
@@ -33,6 +34,10 @@
 #include <trefcounter.h>
 #include <tutils.h>
 
+#ifdef HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
 #include "tstring.h"
 
 namespace
@@ -47,20 +52,189 @@ namespace
     return String::UTF16BE;
   }
 
+#ifdef HAVE_SSE2
+
+  // Helper functions to move eight UTF-16 code units between an SSE2 register
+  // and an array of wchar_t, which may be 16 or 32 bits wide.
+  inline __m128i loadUTF16(const wchar_t *p)
+  {
+    if(sizeof(wchar_t) == 2)
+      return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+    // Keeps the lower 16 bits of each character like utf8::internal::mask16().
+    // After the sign extension, the signed saturation does not change them.
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 4));
+    return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                           _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+  }
+
+  inline void storeUTF16(wchar_t *p, __m128i v)
+  {
+    if(sizeof(wchar_t) == 2) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+    }
+    else {
+      const __m128i zero = _mm_setzero_si128();
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_unpacklo_epi16(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 4), _mm_unpackhi_epi16(v, zero));
+    }
+  }
+
+  inline __m128i byteSwap16(__m128i v)
+  {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  }
+
+#endif
+
+  // Widens the given 8-bit characters to wchar_t.
+  void widen(wchar_t *dst, const unsigned char *s, size_t length)
+  {
+    size_t i = 0;
+
+#ifdef HAVE_SSE2
+
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= length; i += 16) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      storeUTF16(dst + i,     _mm_unpacklo_epi8(v, zero));
+      storeUTF16(dst + i + 8, _mm_unpackhi_epi8(v, zero));
+    }
+
+#endif
+
+    for(; i < length; ++i)
+      dst[i] = s[i];
+  }
+
+  // Narrows the given characters to 8 bits.
+  void narrow(char *dst, const wchar_t *s, size_t length)
+  {
+    size_t i = 0;
+
+#ifdef HAVE_SSE2
+
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128i lowByte = _mm_set1_epi16(0xff);
+    for(; i + 8 <= length; i += 8) {
+      const __m128i v = _mm_and_si128(loadUTF16(s + i), lowByte);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(v, zero));
+    }
+
+#endif
+
+    for(; i < length; ++i)
+      dst[i] = static_cast<char>(s[i]);
+  }
+
   // Converts a Latin-1 string into UTF-16(without BOM/CPU byte order)
   // and copies it to the internal buffer.
   void copyFromLatin1(std::wstring &data, const char *s, size_t length)
   {
     data.resize(length);
 
-    for(size_t i = 0; i < length; ++i)
-      data[i] = static_cast<unsigned char>(s[i]);
+    if(length > 0)
+      widen(&data[0], reinterpret_cast<const unsigned char *>(s), length);
+  }
+
+  // Decodes a UTF-8 string into UTF-16. Returns false if the string is not
+  // valid UTF-8.
+  bool decodeUTF8(std::wstring &data, const char *s, size_t length)
+  {
+    data.resize(length);
+    if(length == 0)
+      return true;
+
+    wchar_t *dst = &data[0];
+    const unsigned char *p   = reinterpret_cast<const unsigned char *>(s);
+    const unsigned char *end = p + length;
+
+    while(p < end) {
+      const unsigned char *blockEnd = end;
+
+#ifdef HAVE_SSE2
+
+      // Copies 16 ASCII characters at once, otherwise decodes the next 16
+      // bytes one by one.
+
+      if(end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        if(_mm_movemask_epi8(v) == 0) {
+          widen(dst, p, 16);
+          dst += 16;
+          p   += 16;
+          continue;
+        }
+        blockEnd = p + 16;
+      }
+
+#endif
+
+      while(p < blockEnd) {
+        if(*p < 0x80) {
+          *dst++ = *p++;
+          continue;
+        }
+
+        const size_t left = end - p;
+        unsigned int c;
+
+        if(*p >= 0xc2 && *p <= 0xdf) {
+          if(left < 2 || (p[1] & 0xc0) != 0x80)
+            return false;
+
+          c = ((p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+          p += 2;
+        }
+        else if(*p >= 0xe0 && *p <= 0xef) {
+          if(left < 3 || (p[1] & 0xc0) != 0x80 || (p[2] & 0xc0) != 0x80)
+            return false;
+
+          c = ((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+          if(c < 0x800 || (c >= 0xd800 && c <= 0xdfff))
+            return false;
+
+          p += 3;
+        }
+        else if(*p >= 0xf0 && *p <= 0xf4) {
+          if(left < 4 || (p[1] & 0xc0) != 0x80 || (p[2] & 0xc0) != 0x80 || (p[3] & 0xc0) != 0x80)
+            return false;
+
+          c = ((p[0] & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+          if(c < 0x10000 || c > 0x10ffff)
+            return false;
+
+          p += 4;
+        }
+        else {
+          return false;
+        }
+
+        if(c > 0xffff) {
+          c -= 0x10000;
+          *dst++ = static_cast<wchar_t>(0xd800 + (c >> 10));
+          *dst++ = static_cast<wchar_t>(0xdc00 + (c & 0x3ff));
+        }
+        else {
+          *dst++ = static_cast<wchar_t>(c);
+        }
+      }
+    }
+
+    data.resize(dst - data.data());
+    return true;
   }
 
   // Converts a UTF-8 string into UTF-16(without BOM/CPU byte order)
   // and copies it to the internal buffer.
   void copyFromUTF8(std::wstring &data, const char *s, size_t length)
   {
+    if(decodeUTF8(data, s, length))
+      return;
+
+    // The string is broken.  Let UTF8-CPP tell what is wrong with it.
+
     data.resize(length);
 
     try {
@@ -74,6 +248,75 @@ namespace
     }
   }
 
+  // Encodes a UTF-16 string into UTF-8. Returns false if the string contains
+  // an unpaired surrogate.
+  bool encodeUTF8(ByteVector &v, const wchar_t *s, size_t length)
+  {
+    v.resize(static_cast<unsigned int>(length * 3));
+    if(length == 0)
+      return true;
+
+    unsigned char *dst = reinterpret_cast<unsigned char *>(v.data());
+    const wchar_t *end = s + length;
+
+    while(s < end) {
+      const wchar_t *blockEnd = end;
+
+#ifdef HAVE_SSE2
+
+      // Copies 8 ASCII characters at once, otherwise encodes the next 8
+      // characters one by one.
+
+      if(end - s >= 8) {
+        const __m128i nonASCII = _mm_set1_epi16(static_cast<short>(0xff80));
+        const __m128i u = _mm_and_si128(loadUTF16(s), nonASCII);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi16(u, _mm_setzero_si128())) == 0xffff) {
+          narrow(reinterpret_cast<char *>(dst), s, 8);
+          dst += 8;
+          s   += 8;
+          continue;
+        }
+        blockEnd = s + 8;
+      }
+
+#endif
+
+      while(s < blockEnd) {
+        unsigned int c = static_cast<unsigned short>(*s++);
+
+        if(c < 0x80) {
+          *dst++ = static_cast<unsigned char>(c);
+        }
+        else if(c < 0x800) {
+          *dst++ = static_cast<unsigned char>(0xc0 | (c >> 6));
+          *dst++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+        else if(c < 0xd800 || c > 0xdfff) {
+          *dst++ = static_cast<unsigned char>(0xe0 | (c >> 12));
+          *dst++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3f));
+          *dst++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+        else {
+          if(c > 0xdbff || s == end)
+            return false;
+
+          const unsigned int trail = static_cast<unsigned short>(*s++);
+          if(trail < 0xdc00 || trail > 0xdfff)
+            return false;
+
+          c = 0x10000 + ((c - 0xd800) << 10) + (trail - 0xdc00);
+          *dst++ = static_cast<unsigned char>(0xf0 | (c >> 18));
+          *dst++ = static_cast<unsigned char>(0x80 | ((c >> 12) & 0x3f));
+          *dst++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3f));
+          *dst++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+      }
+    }
+
+    v.resize(static_cast<unsigned int>(dst - reinterpret_cast<unsigned char *>(v.data())));
+    return true;
+  }
+
   // Helper functions to read a UTF-16 character from an array.
   template <typename T>
   unsigned short nextUTF16(const T **p);
@@ -96,6 +339,41 @@ namespace
     return u.w;
   }
 
+  // Helper functions to copy UTF-16 characters from an array.
+  template <typename T>
+  void copyUTF16(wchar_t *dst, const T *s, size_t length, bool swap)
+  {
+    for(size_t i = 0; i < length; ++i) {
+      const unsigned short c = nextUTF16(&s);
+      if(swap)
+        dst[i] = Utils::byteSwap(c);
+      else
+        dst[i] = c;
+    }
+  }
+
+#ifdef HAVE_SSE2
+
+  template <>
+  void copyUTF16<char>(wchar_t *dst, const char *s, size_t length, bool swap)
+  {
+    size_t i = 0;
+    for(; i + 8 <= length; i += 8) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i * 2));
+      storeUTF16(dst + i, swap ? byteSwap16(v) : v);
+    }
+
+    for(s += i * 2; i < length; ++i) {
+      const unsigned short c = nextUTF16(&s);
+      if(swap)
+        dst[i] = Utils::byteSwap(c);
+      else
+        dst[i] = c;
+    }
+  }
+
+#endif
+
   // Converts a UTF-16 (with BOM), UTF-16LE or UTF16-BE string into
   // UTF-16(without BOM/CPU byte order) and copies it to the internal buffer.
   template <typename T>
@@ -125,12 +403,34 @@ namespace
     }
 
     data.resize(length);
-    for(size_t i = 0; i < length; ++i) {
-      const unsigned short c = nextUTF16(&s);
-      if(swap)
-        data[i] = Utils::byteSwap(c);
-      else
-        data[i] = c;
+    if(length > 0)
+      copyUTF16(&data[0], s, length, swap);
+  }
+
+  // Writes the given characters as UTF-16 in the specified byte order.
+  void copyToUTF16(char *dst, const wchar_t *s, size_t length, bool bigEndian)
+  {
+    size_t i = 0;
+
+#ifdef HAVE_SSE2
+
+    // SSE2 is only available on little-endian CPUs.
+    for(; i + 8 <= length; i += 8) {
+      const __m128i v = loadUTF16(s + i);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2), bigEndian ? byteSwap16(v) : v);
+    }
+
+#endif
+
+    for(; i < length; ++i) {
+      if(bigEndian) {
+        dst[i * 2]     = static_cast<char>(s[i] >> 8);
+        dst[i * 2 + 1] = static_cast<char>(s[i] & 0xff);
+      }
+      else {
+        dst[i * 2]     = static_cast<char>(s[i] & 0xff);
+        dst[i * 2 + 1] = static_cast<char>(s[i] >> 8);
+      }
     }
   }
 }  // namespace
@@ -140,9 +440,23 @@ namespace TagLib {
 class String::StringPrivate : public RefCounter
 {
 public:
-  StringPrivate()
+  StringPrivate() :
+    hasUTF8(false)
     {}
 
+  /*!
+   * Keeps the UTF-8 data \a s which the string has been created from, unless
+   * it could not be converted.
+   */
+  void setUTF8(const char *s, size_t length)
+  {
+    if(length > 0 && data.empty())
+      return;
+
+    utf8.assign(s, length);
+    hasUTF8 = true;
+  }
+
   /*!
    * Stores string in UTF-16. The byte order depends on the CPU endian.
    */
@@ -152,6 +466,15 @@ public:
    * This is only used to hold the the most recent value of toCString().
    */
   std::string cstring;
+
+  /*!
+   * The string in UTF-8, if hasUTF8 is true.  This is kept from the data the
+   * string has been created from, until the string is detached for writing.
+   * It is never set afterwards, since the characters can be changed through
+   * iterators without detaching again.
+   */
+  std::string utf8;
+  bool hasUTF8;
 };
 
 String String::null;
@@ -176,8 +499,10 @@ String::String(const std::string &s, Type t) :
 {
   if(t == Latin1)
     copyFromLatin1(d->data, s.c_str(), s.length());
-  else if(t == String::UTF8)
+  else if(t == String::UTF8) {
     copyFromUTF8(d->data, s.c_str(), s.length());
+    d->setUTF8(s.c_str(), s.length());
+  }
   else {
     debug("String::String() -- std::string should not contain UTF16.");
   }
@@ -224,8 +549,11 @@ String::String(const char *s, Type t) :
 {
   if(t == Latin1)
     copyFromLatin1(d->data, s, ::strlen(s));
-  else if(t == String::UTF8)
-    copyFromUTF8(d->data, s, ::strlen(s));
+  else if(t == String::UTF8) {
+    const size_t length = ::strlen(s);
+    copyFromUTF8(d->data, s, length);
+    d->setUTF8(s, length);
+  }
   else {
     debug("String::String() -- const char * should not contain UTF16.");
   }
@@ -268,6 +596,11 @@ String::String(const ByteVector &v, Type t) :
 
   // If we hit a null in the ByteVector, shrink the string again.
   d->data.resize(::wcslen(d->data.c_str()));
+
+  if(t == UTF8) {
+    const char *end = static_cast<const char *>(::memchr(v.data(), '\0', v.size()));
+    d->setUTF8(v.data(), end ? end - v.data() : v.size());
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -280,6 +613,9 @@ String::~String()
 
 std::string String::to8Bit(bool unicode) const
 {
+  if(unicode && d->hasUTF8)
+    return d->utf8;
+
   const ByteVector v = data(unicode ? UTF8 : Latin1);
   return std::string(v.data(), v.size());
 }
@@ -291,6 +627,9 @@ TagLib::wstring String::toWString() const
 
 const char *String::toCString(bool unicode) const
 {
+  if(unicode && d->hasUTF8)
+    return d->utf8.c_str();
+
   d->cstring = to8Bit(unicode);
   return d->cstring.c_str();
 }
@@ -417,16 +756,22 @@ ByteVector String::data(Type t) const
   case Latin1:
     {
       ByteVector v(size(), 0);
-      char *p = v.data();
-
-      for(ConstIterator it = begin(); it != end(); ++it)
-        *p++ = static_cast<char>(*it);
+      narrow(v.data(), d->data.data(), d->data.size());
 
       return v;
     }
   case UTF8:
     {
-      ByteVector v(size() * 4, 0);
+      if(d->hasUTF8)
+        return ByteVector(d->utf8.data(), static_cast<unsigned int>(d->utf8.size()));
+
+      ByteVector v;
+      if(encodeUTF8(v, d->data.data(), d->data.size()))
+        return v;
+
+      // The string is broken.  Let UTF8-CPP tell what is wrong with it.
+
+      v.resize(size() * 4);
 
       try {
         const ByteVector::Iterator dstEnd = utf8::utf16to8(begin(), end(), v.begin());
@@ -450,34 +795,21 @@ ByteVector String::data(Type t) const
       *p++ = '\xff';
       *p++ = '\xfe';
 
-      for(ConstIterator it = begin(); it != end(); ++it) {
-        *p++ = static_cast<char>(*it & 0xff);
-        *p++ = static_cast<char>(*it >> 8);
-      }
+      copyToUTF16(p, d->data.data(), d->data.size(), false);
 
       return v;
     }
   case UTF16BE:
     {
       ByteVector v(size() * 2, 0);
-      char *p = v.data();
-
-      for(ConstIterator it = begin(); it != end(); ++it) {
-        *p++ = static_cast<char>(*it >> 8);
-        *p++ = static_cast<char>(*it & 0xff);
-      }
+      copyToUTF16(v.data(), d->data.data(), d->data.size(), true);
 
       return v;
     }
   case UTF16LE:
     {
       ByteVector v(size() * 2, 0);
-      char *p = v.data();
-
-      for(ConstIterator it = begin(); it != end(); ++it) {
-        *p++ = static_cast<char>(*it & 0xff);
-        *p++ = static_cast<char>(*it >> 8);
-      }
+      copyToUTF16(v.data(), d->data.data(), d->data.size(), false);
 
       return v;
     }
@@ -701,6 +1033,8 @@ void String::detach()
 {
   if(d->count() > 1)
     String(d->data.c_str()).swap(*this);
+  else
+    d->hasUTF8 = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
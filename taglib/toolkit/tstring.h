@@ -215,6 +215,9 @@ namespace TagLib {
      * The returned pointer remains valid until this String instance is destroyed
      * or toCString() is called again.
      *
+     * If this String has been created from UTF-8 data and not modified since,
+     * the UTF-8 string is returned without any conversion or allocation.
+     *
      * \warning This however has the side effect that the returned string will remain
      * in memory <b>in addition to</b> other memory that is consumed by this
      * String instance.  So, this method should not be used on large strings or
@@ -85,6 +85,9 @@ StringList::~StringList()
 
 String StringList::toString(const String &separator) const
 {
+  if(size() == 1)
+    return front();
+
   String s;
 
   ConstIterator it = begin();
@@ -50,53 +50,298 @@ bool zlib::isAvailable()
 #endif
 }
 
+namespace
+{
+  // Deflate can not expand data more than this, so a larger size hint for
+  // the decompressed data is not trusted.
+  const unsigned int MaxCompressionRatio = 1032;
+
+  const unsigned int ChunkSize = 1024;
+}
+
 ByteVector zlib::decompress(const ByteVector &data)
 {
-#ifdef HAVE_ZLIB
+  return decompress(data, 0);
+}
 
-  z_stream stream = {};
+ByteVector zlib::decompress(const ByteVector &data, unsigned int size)
+{
+  Inflater inflater(size);
 
-  if(inflateInit(&stream) != Z_OK) {
-    debug("zlib::decompress() - Failed to initialize zlib.");
+  if(!inflater.write(data))
     return ByteVector();
+
+  return inflater.output();
+}
+
+ByteVector zlib::compress(const ByteVector &data)
+{
+  Deflater deflater;
+
+  if(!deflater.write(data))
+    return ByteVector();
+
+  return deflater.finish();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Inflater
+////////////////////////////////////////////////////////////////////////////////
+
+class zlib::Inflater::InflaterPrivate
+{
+public:
+  InflaterPrivate(unsigned int hint) :
+    sizeHint(hint),
+    length(0),
+    initialized(false),
+    finished(false) {}
+
+#ifdef HAVE_ZLIB
+  z_stream stream;
+#endif
+
+  unsigned int sizeHint;
+
+  // The output buffer is larger than the data which has been decompressed,
+  // the size of which is length.
+  ByteVector output;
+  unsigned int length;
+
+  bool initialized;
+  bool finished;
+};
+
+zlib::Inflater::Inflater(unsigned int sizeHint) :
+  d(new InflaterPrivate(sizeHint))
+{
+#ifdef HAVE_ZLIB
+
+  d->stream = z_stream();
+
+  if(inflateInit(&d->stream) == Z_OK)
+    d->initialized = true;
+  else
+    debug("zlib::Inflater::Inflater() - Failed to initialize zlib.");
+
+#endif
+}
+
+zlib::Inflater::~Inflater()
+{
+#ifdef HAVE_ZLIB
+
+  if(d->initialized)
+    inflateEnd(&d->stream);
+
+#endif
+
+  delete d;
+}
+
+bool zlib::Inflater::write(const ByteVector &data)
+{
+#ifdef HAVE_ZLIB
+
+  if(!d->initialized)
+    return false;
+
+  // Anything after the end of the stream is ignored.
+
+  if(d->finished)
+    return true;
+
+  if(d->output.isEmpty()) {
+    unsigned int size = d->sizeHint;
+    if(size / MaxCompressionRatio > data.size())
+      size = data.size() * MaxCompressionRatio;
+
+    d->output.resize(size > 0 ? size : ChunkSize);
   }
 
-  ByteVector inData = data;
+  d->stream.avail_in = static_cast<uInt>(data.size());
+  d->stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+
+  while(true) {
+    if(d->length == d->output.size())
+      d->output.resize(d->output.size() * 2);
 
-  stream.avail_in = static_cast<uInt>(inData.size());
-  stream.next_in  = reinterpret_cast<Bytef *>(inData.data());
+    d->stream.avail_out = static_cast<uInt>(d->output.size() - d->length);
+    d->stream.next_out  = reinterpret_cast<Bytef *>(d->output.data() + d->length);
 
-  const unsigned int chunkSize = 1024;
+    const int result = inflate(&d->stream, Z_NO_FLUSH);
 
-  ByteVector outData;
+    d->length = d->output.size() - d->stream.avail_out;
 
-  do {
-    const size_t offset = outData.size();
-    outData.resize(outData.size() + chunkSize);
+    if(result == Z_STREAM_END) {
+      d->finished = true;
+      break;
+    }
 
-    stream.avail_out = static_cast<uInt>(chunkSize);
-    stream.next_out  = reinterpret_cast<Bytef *>(outData.data() + offset);
+    if(result != Z_OK && result != Z_BUF_ERROR) {
+      inflateEnd(&d->stream);
+      d->initialized = false;
 
-    const int result = inflate(&stream, Z_NO_FLUSH);
+      debug("zlib::Inflater::write() - Error reading compressed stream.");
+      return false;
+    }
 
-    if(result == Z_STREAM_ERROR ||
-       result == Z_NEED_DICT ||
-       result == Z_DATA_ERROR ||
-       result == Z_MEM_ERROR)
-    {
-      if(result != Z_STREAM_ERROR)
-        inflateEnd(&stream);
+    // If there is space left in the output, all of the input has been used.
 
-      debug("zlib::decompress() - Error reading compressed stream.");
-      return ByteVector();
+    if(d->stream.avail_out != 0)
+      break;
+  }
+
+  return true;
+
+#else
+
+  return false;
+
+#endif
+}
+
+bool zlib::Inflater::isFinished() const
+{
+  return d->finished;
+}
+
+ByteVector zlib::Inflater::output() const
+{
+  d->output.resize(d->length);
+  return d->output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Deflater
+////////////////////////////////////////////////////////////////////////////////
+
+class zlib::Deflater::DeflaterPrivate
+{
+public:
+  DeflaterPrivate() :
+    length(0),
+    initialized(false),
+    finished(false) {}
+
+#ifdef HAVE_ZLIB
+  z_stream stream;
+
+  bool deflate(const ByteVector &data, int flush);
+#endif
+
+  // The output buffer is larger than the data which has been compressed,
+  // the size of which is length.
+  ByteVector output;
+  unsigned int length;
+
+  bool initialized;
+  bool finished;
+};
+
+#ifdef HAVE_ZLIB
+
+bool zlib::Deflater::DeflaterPrivate::deflate(const ByteVector &data, int flush)
+{
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+
+  while(true) {
+
+    // deflateBound() is large enough for the whole stream if the data is
+    // passed in one piece, so usually this allocates only once.
+
+    if(length == output.size()) {
+      const unsigned int bound = static_cast<unsigned int>(deflateBound(&stream, stream.avail_in));
+      output.resize(output.size() + (bound > ChunkSize ? bound : ChunkSize));
+    }
+
+    stream.avail_out = static_cast<uInt>(output.size() - length);
+    stream.next_out  = reinterpret_cast<Bytef *>(output.data() + length);
+
+    const int result = ::deflate(&stream, flush);
+
+    length = output.size() - stream.avail_out;
+
+    if(result == Z_STREAM_END)
+      return true;
+
+    if(result != Z_OK && result != Z_BUF_ERROR) {
+      debug("zlib::Deflater::write() - Error writing compressed stream.");
+      return false;
     }
 
-    outData.resize(outData.size() - stream.avail_out);
-  } while(stream.avail_out == 0);
+    // If there is space left in the output, all of the input has been used.
 
-  inflateEnd(&stream);
+    if(stream.avail_out != 0) {
+      if(flush != Z_FINISH)
+        return true;
+
+      if(result == Z_BUF_ERROR) {
+        debug("zlib::Deflater::finish() - Failed to finish compressed stream.");
+        return false;
+      }
+    }
+  }
+}
+
+#endif
+
+zlib::Deflater::Deflater() :
+  d(new DeflaterPrivate())
+{
+#ifdef HAVE_ZLIB
+
+  d->stream = z_stream();
+
+  if(deflateInit(&d->stream, Z_DEFAULT_COMPRESSION) == Z_OK)
+    d->initialized = true;
+  else
+    debug("zlib::Deflater::Deflater() - Failed to initialize zlib.");
+
+#endif
+}
+
+zlib::Deflater::~Deflater()
+{
+#ifdef HAVE_ZLIB
+
+  if(d->initialized)
+    deflateEnd(&d->stream);
+
+#endif
+
+  delete d;
+}
+
+bool zlib::Deflater::write(const ByteVector &data)
+{
+#ifdef HAVE_ZLIB
+
+  if(!d->initialized || d->finished)
+    return false;
+
+  return d->deflate(data, Z_NO_FLUSH);
+
+#else
+
+  return false;
+
+#endif
+}
+
+ByteVector zlib::Deflater::finish()
+{
+#ifdef HAVE_ZLIB
+
+  if(d->initialized && !d->finished) {
+    d->finished = true;
+    if(!d->deflate(ByteVector(), Z_FINISH))
+      return ByteVector();
+  }
 
-  return outData;
+  d->output.resize(d->length);
+  return d->output;
 
 #else
 
@@ -44,8 +44,95 @@ namespace TagLib {
      /*!
       * Decompress \a data by zlib.
       */
-     ByteVector decompress(const ByteVector &data);
+     ByteVector TAGLIB_EXPORT decompress(const ByteVector &data);
 
+     /*!
+      * Decompress \a data by zlib.  \a size is the expected size of the
+      * decompressed data, which is allocated up front.
+      */
+     ByteVector TAGLIB_EXPORT decompress(const ByteVector &data, unsigned int size);
+
+     /*!
+      * Compress \a data by zlib.
+      */
+     ByteVector TAGLIB_EXPORT compress(const ByteVector &data);
+
+     /*!
+      * Decompresses a zlib stream, which may be passed in several pieces.
+      */
+     class TAGLIB_EXPORT Inflater
+     {
+     public:
+       /*!
+        * Constructs an inflater.  If \a sizeHint is not 0, it is the expected
+        * size of the decompressed data, which is allocated up front.
+        */
+       explicit Inflater(unsigned int sizeHint = 0);
+
+       /*!
+        * Destroys the inflater.
+        */
+       ~Inflater();
+
+       /*!
+        * Decompresses \a data and appends it to the output.  Returns false if
+        * the stream is broken.
+        */
+       bool write(const ByteVector &data);
+
+       /*!
+        * Returns true if the end of the stream has been reached.
+        */
+       bool isFinished() const;
+
+       /*!
+        * Returns the data which has been decompressed so far.
+        */
+       ByteVector output() const;
+
+     private:
+       Inflater(const Inflater &);
+       Inflater &operator=(const Inflater &);
+
+       class InflaterPrivate;
+       InflaterPrivate *d;
+     };
+
+     /*!
+      * Compresses data into a zlib stream, which may be passed in several
+      * pieces.
+      */
+     class TAGLIB_EXPORT Deflater
+     {
+     public:
+       /*!
+        * Constructs a deflater.
+        */
+       Deflater();
+
+       /*!
+        * Destroys the deflater.
+        */
+       ~Deflater();
+
+       /*!
+        * Compresses \a data and appends it to the output.  Returns false if
+        * the stream has already been finished or an error occurred.
+        */
+       bool write(const ByteVector &data);
+
+       /*!
+        * Ends the stream and returns the compressed data.
+        */
+       ByteVector finish();
+
+     private:
+       Deflater(const Deflater &);
+       Deflater &operator=(const Deflater &);
+
+       class DeflaterPrivate;
+       DeflaterPrivate *d;
+     };
   }
 }
 
@@ -177,7 +177,7 @@ bool TrueAudio::File::save()
     if(d->ID3v2Location < 0)
       d->ID3v2Location = 0;
 
-    const ByteVector data = ID3v2Tag()->render();
+    const ByteVector data = ID3v2Tag()->render(ID3v2::v4, this);
     insert(data, d->ID3v2Location, d->ID3v2OriginalSize);
 
     if(d->ID3v1Location >= 0)
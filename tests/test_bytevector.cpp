@@ -39,6 +39,7 @@ class TestByteVector : public CppUnit::TestFixture
   CPPUNIT_TEST(testFind1);
   CPPUNIT_TEST(testFind2);
   CPPUNIT_TEST(testFind3);
+  CPPUNIT_TEST(testFind4);
   CPPUNIT_TEST(testRfind1);
   CPPUNIT_TEST(testRfind2);
   CPPUNIT_TEST(testRfind3);
@@ -121,6 +122,30 @@ public:
     CPPUNIT_ASSERT_EQUAL(-1, ByteVector("....SggO."). find('S', 8));
   }
 
+  void testFind4()
+  {
+    const ByteVector v("OOgOggOggSOggS");
+    CPPUNIT_ASSERT_EQUAL(6, v.find("OggS"));
+    CPPUNIT_ASSERT_EQUAL(6, v.find("OggS", 6));
+    CPPUNIT_ASSERT_EQUAL(10, v.find("OggS", 7));
+    CPPUNIT_ASSERT_EQUAL(-1, v.find("OggS", 11));
+    CPPUNIT_ASSERT_EQUAL(-1, v.find("OggSx"));
+    CPPUNIT_ASSERT_EQUAL(-1, v.find(""));
+    CPPUNIT_ASSERT_EQUAL(-1, ByteVector().find("O"));
+    CPPUNIT_ASSERT_EQUAL(-1, ByteVector().find('O'));
+
+    // The aligned search must give the same results as the unaligned one.
+
+    CPPUNIT_ASSERT_EQUAL(6, v.find("OggS", 0, 2));
+    CPPUNIT_ASSERT_EQUAL(-1, v.find("OggS", 0, 4));
+    CPPUNIT_ASSERT_EQUAL(9, v.find('S', 1, 4));
+
+    ByteVector data(100000, 'O');
+    data.append("OggS");
+    CPPUNIT_ASSERT_EQUAL(100000, data.find("OggS"));
+    CPPUNIT_ASSERT_EQUAL(100003, data.find('S'));
+  }
+
   void testRfind1()
   {
     CPPUNIT_ASSERT_EQUAL(1, ByteVector(".OggS....").rfind("OggS", 0));
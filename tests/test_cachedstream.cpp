@@ -0,0 +1,169 @@
+/***************************************************************************
+    copyright           : (C) 2026 by the TagLib developers
+    email               : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it  under the terms of the GNU Lesser General Public License version  *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <tcachedstream.h>
+#include <tbytevectorstream.h>
+#include <tfilestream.h>
+#include <mpegfile.h>
+#include <id3v2framefactory.h>
+#include <tag.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "utils.h"
+
+using namespace std;
+using namespace TagLib;
+
+class TestCachedStream : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestCachedStream);
+  CPPUNIT_TEST(testReadBlock);
+  CPPUNIT_TEST(testReadAcrossBlocks);
+  CPPUNIT_TEST(testReadLargeBlock);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testWriteBlock);
+  CPPUNIT_TEST(testInsert);
+  CPPUNIT_TEST(testSaveMPEG);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void testReadBlock()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 8);
+
+    CPPUNIT_ASSERT_EQUAL(10L, stream.length());
+    CPPUNIT_ASSERT_EQUAL(ByteVector("01"), stream.readBlock(2));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("23"), stream.readBlock(2));
+    CPPUNIT_ASSERT_EQUAL(4L, stream.tell());
+    CPPUNIT_ASSERT_EQUAL(ByteVector("4567"), stream.readBlock(4));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("89"), stream.readBlock(4));
+    CPPUNIT_ASSERT_EQUAL(10L, stream.tell());
+    CPPUNIT_ASSERT(stream.readBlock(4).isEmpty());
+  }
+
+  void testReadAcrossBlocks()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 4);
+
+    stream.seek(3);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("3456"), stream.readBlock(4));
+    stream.seek(1);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("1234"), stream.readBlock(4));
+    stream.seek(7);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("789"), stream.readBlock(4));
+  }
+
+  void testReadLargeBlock()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 8);
+
+    stream.seek(2);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("234567"), stream.readBlock(6));
+    CPPUNIT_ASSERT_EQUAL(8L, stream.tell());
+    CPPUNIT_ASSERT_EQUAL(ByteVector("89"), stream.readBlock(100));
+  }
+
+  void testSeek()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 8);
+
+    stream.seek(5);
+    CPPUNIT_ASSERT_EQUAL(5L, stream.tell());
+    stream.seek(2, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(7L, stream.tell());
+    stream.seek(-20, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(7L, stream.tell());
+    stream.seek(-3, IOStream::End);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("789"), stream.readBlock(3));
+  }
+
+  void testWriteBlock()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 8);
+
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123"), stream.readBlock(4));
+    stream.seek(2);
+    stream.writeBlock(ByteVector("xy"));
+    CPPUNIT_ASSERT_EQUAL(4L, stream.tell());
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("01xy"), stream.readBlock(4));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("01xy456789"), *data.data());
+  }
+
+  void testInsert()
+  {
+    ByteVectorStream data(ByteVector("0123456789"));
+    CachedStream stream(&data, 4, 8);
+
+    CPPUNIT_ASSERT_EQUAL(10L, stream.length());
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123"), stream.readBlock(4));
+
+    stream.insert(ByteVector("abc"), 2, 1);
+    CPPUNIT_ASSERT_EQUAL(12L, stream.length());
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("01abc3"), stream.readBlock(6));
+
+    stream.removeBlock(0, 5);
+    CPPUNIT_ASSERT_EQUAL(7L, stream.length());
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("3456"), stream.readBlock(4));
+  }
+
+  void testSaveMPEG()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string name = copy.fileName();
+
+    {
+      FileStream file(name.c_str());
+      CachedStream stream(&file, 4096);
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(!f.hasID3v2Tag());
+      f.tag()->setTitle("Title");
+      f.save();
+    }
+    {
+      FileStream file(name.c_str(), true);
+      CachedStream stream(&file, 4096);
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(f.hasID3v2Tag());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+
+      MPEG::File f2(name.c_str());
+      CPPUNIT_ASSERT_EQUAL(f2.audioProperties()->lengthInMilliseconds(),
+                           f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestCachedStream);
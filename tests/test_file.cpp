@@ -24,6 +24,8 @@
  ***************************************************************************/
 
 #include <tfile.h>
+#include <tfilestream.h>
+#include <tbytevectorstream.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "plainfile.h"
 #include "utils.h"
@@ -35,8 +37,13 @@ class TestFile : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(TestFile);
   CPPUNIT_TEST(testFindInSmallFile);
   CPPUNIT_TEST(testRFindInSmallFile);
+  CPPUNIT_TEST(testFindAcrossBuffers);
+  CPPUNIT_TEST(testRFindAcrossBuffers);
+  CPPUNIT_TEST(testFindWithLimit);
   CPPUNIT_TEST(testSeek);
   CPPUNIT_TEST(testTruncate);
+  CPPUNIT_TEST(testFileDescriptor);
+  CPPUNIT_TEST(testInsertAndRemove);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -97,6 +104,90 @@ public:
     }
   }
 
+  void testFindAcrossBuffers()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    {
+      PlainFile file(name.c_str());
+      ByteVector data(10000, 'x');
+      ::memcpy(data.data() + 1022, "ABCD", 4);
+      ::memcpy(data.data() + 7000, "ABCD", 4);
+      ::memcpy(data.data() + 9000, "WXYZ", 4);
+      file.seek(0);
+      file.writeBlock(data);
+      file.truncate(10000);
+    }
+    {
+      PlainFile file(name.c_str());
+      CPPUNIT_ASSERT_EQUAL(65536U, file.searchBufferSize());
+      CPPUNIT_ASSERT_EQUAL(1022L, file.find("ABCD"));
+      CPPUNIT_ASSERT_EQUAL(7000L, file.find("ABCD", 1023));
+      CPPUNIT_ASSERT_EQUAL(-1L, file.find("ABCDE"));
+
+      file.setSearchBufferSize(3);
+      CPPUNIT_ASSERT_EQUAL(1022L, file.find("ABCD"));
+      CPPUNIT_ASSERT_EQUAL(7000L, file.find("ABCD", 1023));
+      CPPUNIT_ASSERT_EQUAL(9000L, file.find("WXYZ", 0, "ABCDE"));
+      CPPUNIT_ASSERT_EQUAL(-1L, file.find("WXYZ", 0, "ABCD"));
+      CPPUNIT_ASSERT_EQUAL(0L, file.tell());
+    }
+  }
+
+  void testRFindAcrossBuffers()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    {
+      PlainFile file(name.c_str());
+      ByteVector data(10000, 'x');
+      ::memcpy(data.data() + 1000, "WXYZ", 4);
+      ::memcpy(data.data() + 3000, "ABCD", 4);
+      ::memcpy(data.data() + 8975, "ABCD", 4);
+      file.seek(0);
+      file.writeBlock(data);
+      file.truncate(10000);
+    }
+    {
+      PlainFile file(name.c_str());
+      CPPUNIT_ASSERT_EQUAL(8975L, file.rfind("ABCD"));
+      CPPUNIT_ASSERT_EQUAL(8975L, file.rfind("ABCD", 8975));
+      CPPUNIT_ASSERT_EQUAL(3000L, file.rfind("ABCD", 8974));
+      CPPUNIT_ASSERT_EQUAL(1000L, file.rfind("WXYZ"));
+      CPPUNIT_ASSERT_EQUAL(-1L, file.rfind("WXYZ", 0, "ABCD"));
+
+      file.setSearchBufferSize(5);
+      CPPUNIT_ASSERT_EQUAL(8975L, file.rfind("ABCD"));
+      CPPUNIT_ASSERT_EQUAL(3000L, file.rfind("ABCD", 8974));
+      CPPUNIT_ASSERT_EQUAL(1000L, file.rfind("WXYZ", 0, "ABCDE"));
+      CPPUNIT_ASSERT_EQUAL(0L, file.tell());
+    }
+  }
+
+  void testFindWithLimit()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    {
+      PlainFile file(name.c_str());
+      ByteVector data(10000, 'x');
+      ::memcpy(data.data() + 5000, "ABCD", 4);
+      file.seek(0);
+      file.writeBlock(data);
+      file.truncate(10000);
+    }
+    {
+      PlainFile file(name.c_str());
+      CPPUNIT_ASSERT_EQUAL(5000L, file.find("ABCD", 0, ByteVector(), 5004));
+      CPPUNIT_ASSERT_EQUAL(-1L, file.find("ABCD", 0, ByteVector(), 5003));
+      CPPUNIT_ASSERT_EQUAL(5000L, file.find("ABCD", 0, ByteVector(), -1));
+
+      CPPUNIT_ASSERT_EQUAL(5000L, file.rfind("ABCD", 0, ByteVector(), 5000));
+      CPPUNIT_ASSERT_EQUAL(-1L, file.rfind("ABCD", 0, ByteVector(), 5001));
+      CPPUNIT_ASSERT_EQUAL(5000L, file.rfind("ABCD", 0, ByteVector(), -1));
+    }
+  }
+
   void testSeek()
   {
     ScopedFileCopy copy("empty", ".ogg");
@@ -139,7 +230,89 @@ public:
     }
   }
 
+  void testFileDescriptor()
+  {
+#ifndef _WIN32
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    {
+      const int fd = ::open(name.c_str(), O_RDONLY);
+      ::lseek(fd, 100, SEEK_SET);
+
+      FileStream stream(fd);
+      CPPUNIT_ASSERT(stream.isOpen());
+      CPPUNIT_ASSERT(stream.readOnly());
+      CPPUNIT_ASSERT_EQUAL(100L, stream.tell());
+      CPPUNIT_ASSERT_EQUAL(4328L, stream.length());
+
+      stream.seek(0);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("OggS"), stream.readBlock(4));
+      CPPUNIT_ASSERT_EQUAL(4L, stream.tell());
+    }
+    {
+      const int fd = ::open(name.c_str(), O_RDWR);
+
+      FileStream stream(fd);
+      CPPUNIT_ASSERT(stream.isOpen());
+      CPPUNIT_ASSERT(!stream.readOnly());
+
+      stream.seek(-4, IOStream::End);
+      stream.writeBlock(ByteVector("ABCD"));
+      stream.writeBlock(ByteVector("EFGH"));
+      CPPUNIT_ASSERT_EQUAL(4332L, stream.length());
+
+      stream.seek(-8, IOStream::End);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("ABCDEFGH"), stream.readBlock(100));
+    }
+#endif
+  }
+
+  void testInsertAndRemove()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    ByteVector data;
+    for(int i = 0; i < 10000; ++i)
+      data.append(static_cast<char>(i * 7 + i / 256));
+
+    ByteVectorStream expected(data);
+    {
+      FileStream file(name.c_str());
+      file.writeBlock(data);
+      file.truncate(data.size());
+    }
+
+    // Shifts smaller and larger than the copy buffer, in both directions.
+
+    const ByteVector small(100, 'a');
+    const ByteVector large(5000, 'b');
+
+    FileStream file(name.c_str());
+    file.setCopyBufferSize(1024);
+    CPPUNIT_ASSERT_EQUAL(1024U, file.copyBufferSize());
+
+    file.insert(small, 10, 0);
+    expected.insert(small, 10, 0);
+    file.insert(large, 3000, 20);
+    expected.insert(large, 3000, 20);
+    file.insert(small, expected.length(), 0);
+    expected.insert(small, expected.length(), 0);
+    file.insert(small, 500, 3000);
+    expected.insert(small, 500, 3000);
+    file.removeBlock(50, 2000);
+    expected.removeBlock(50, 2000);
+    file.removeBlock(10, 10);
+    expected.removeBlock(10, 10);
+    file.removeBlock(expected.length() - 100, 1000);
+    expected.removeBlock(expected.length() - 100, 1000);
+
+    CPPUNIT_ASSERT_EQUAL(expected.length(), file.length());
+    file.seek(0);
+    CPPUNIT_ASSERT(*expected.data() == file.readBlock(file.length()));
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestFile);
-
@@ -88,11 +88,50 @@ class TestFileRef : public CppUnit::TestFixture
   CPPUNIT_TEST(testCreate);
   CPPUNIT_TEST(testAudioProperties);
   CPPUNIT_TEST(testDefaultFileExtensions);
+  CPPUNIT_TEST(testSaveAtomically);
+  CPPUNIT_TEST(testSaveAtomicallyStream);
+  CPPUNIT_TEST(testSaveAtomicallySymlink);
+  CPPUNIT_TEST(testReadParts);
   CPPUNIT_TEST(testFileResolver);
   CPPUNIT_TEST_SUITE_END();
 
 public:
 
+  ByteVector fileRefSaveContents(const string &filename, const string &ext, bool atomically)
+  {
+    ScopedFileCopy copy(filename, ext);
+    string newname = copy.fileName();
+
+    {
+      FileRef f(newname.c_str());
+      CPPUNIT_ASSERT(!f.isNull());
+      f.tag()->setArtist("test artist");
+      f.tag()->setTitle(String(std::string(5000, 'x')));
+      if(atomically)
+        CPPUNIT_ASSERT(f.saveAtomically());
+      else
+        CPPUNIT_ASSERT(f.save());
+
+      // The file has to stay usable after it has been replaced.
+
+      f.tag()->setAlbum("albummmm");
+      if(atomically)
+        CPPUNIT_ASSERT(f.saveAtomically());
+      else
+        CPPUNIT_ASSERT(f.save());
+    }
+    {
+      FileRef f(newname.c_str());
+      CPPUNIT_ASSERT(!f.isNull());
+      CPPUNIT_ASSERT_EQUAL(String("test artist"), f.tag()->artist());
+      CPPUNIT_ASSERT_EQUAL(String("albummmm"), f.tag()->album());
+      CPPUNIT_ASSERT_EQUAL(5000U, f.tag()->title().size());
+    }
+
+    FileStream stream(newname.c_str(), true);
+    return stream.readBlock(stream.length());
+  }
+
   template <typename T>
   void fileRefSave(const string &filename, const string &ext)
   {
@@ -373,6 +412,128 @@ public:
     CPPUNIT_ASSERT(extensions.contains("xm"));
   }
 
+  void testSaveAtomically()
+  {
+    const char *files[][2] = {
+      { "xing", ".mp3" },
+      { "has-tags", ".m4a" },
+      { "click", ".mpc" },
+      { "empty", ".aiff" },
+      { "silence-1", ".wma" }
+    };
+
+    for(size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+      const ByteVector expected = fileRefSaveContents(files[i][0], files[i][1], false);
+      const ByteVector actual = fileRefSaveContents(files[i][0], files[i][1], true);
+      CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+      CPPUNIT_ASSERT(expected == actual);
+    }
+  }
+
+  void testSaveAtomicallyStream()
+  {
+    ByteVector data;
+    {
+      FileStream fs(TEST_FILE_PATH_C("xing.mp3"), true);
+      data = fs.readBlock(fs.length());
+    }
+
+    ByteVectorStream stream(data);
+    FileRef f(&stream);
+    CPPUNIT_ASSERT(!f.isNull());
+    f.tag()->setTitle("test title");
+    CPPUNIT_ASSERT(!f.saveAtomically());
+    CPPUNIT_ASSERT(f.save());
+
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+
+    {
+      FileStream fs(newname.c_str());
+      FileRef f(&fs);
+      CPPUNIT_ASSERT(!f.isNull());
+      f.tag()->setTitle("test title");
+      CPPUNIT_ASSERT(f.saveAtomically());
+      CPPUNIT_ASSERT(fs.isOpen());
+      CPPUNIT_ASSERT(!fs.readOnly());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("ID3"), fs.readBlock(3));
+    }
+    {
+      FileRef f(newname.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("test title"), f.tag()->title());
+    }
+  }
+
+  void testSaveAtomicallySymlink()
+  {
+#ifndef _WIN32
+    ScopedFileCopy copy("xing", ".mp3");
+    const string target = copy.fileName();
+    const string link = target + ".link";
+
+    ::chmod(target.c_str(), 0640);
+    ::unlink(link.c_str());
+    CPPUNIT_ASSERT_EQUAL(0, ::symlink(target.c_str(), link.c_str()));
+
+    {
+      FileRef f(link.c_str());
+      CPPUNIT_ASSERT(!f.isNull());
+      f.tag()->setTitle("test title");
+      CPPUNIT_ASSERT(f.saveAtomically());
+    }
+
+    // The target is replaced and keeps its permissions, the link stays.
+
+    struct stat st;
+    CPPUNIT_ASSERT_EQUAL(0, ::lstat(link.c_str(), &st));
+    CPPUNIT_ASSERT(S_ISLNK(st.st_mode));
+    CPPUNIT_ASSERT_EQUAL(0, ::lstat(target.c_str(), &st));
+    CPPUNIT_ASSERT(S_ISREG(st.st_mode));
+    CPPUNIT_ASSERT_EQUAL(static_cast<mode_t>(0640), static_cast<mode_t>(st.st_mode & 07777));
+    CPPUNIT_ASSERT_EQUAL(::getuid(), st.st_uid);
+    {
+      FileRef f(target.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("test title"), f.tag()->title());
+    }
+
+    ::unlink(link.c_str());
+#endif
+  }
+
+  void testReadParts()
+  {
+    const char *files[][2] = {
+      { "xing", ".mp3" },
+      { "no-tags", ".m4a" }
+    };
+
+    for(size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+      ScopedFileCopy copy(files[i][0], files[i][1]);
+      string newname = copy.fileName();
+
+      {
+        FileRef f(newname.c_str());
+        f.tag()->setTitle("test title");
+        CPPUNIT_ASSERT(f.save());
+      }
+      {
+        FileRef f(newname.c_str(), File::ReadProperties);
+        CPPUNIT_ASSERT(!f.isNull());
+        CPPUNIT_ASSERT(f.audioProperties());
+        CPPUNIT_ASSERT(f.audioProperties()->lengthInMilliseconds() > 0);
+        CPPUNIT_ASSERT(f.tag()->title().isEmpty());
+        f.tag()->setTitle("new title");
+        CPPUNIT_ASSERT(!f.save());
+      }
+      {
+        FileRef f(newname.c_str(), File::ReadTags | File::ReadPictures);
+        CPPUNIT_ASSERT(!f.isNull());
+        CPPUNIT_ASSERT(!f.audioProperties());
+        CPPUNIT_ASSERT_EQUAL(String("test title"), f.tag()->title());
+      }
+    }
+  }
+
   void testFileResolver()
   {
     {
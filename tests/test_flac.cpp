@@ -46,6 +46,8 @@ class TestFLAC : public CppUnit::TestFixture
   CPPUNIT_TEST(testSignature);
   CPPUNIT_TEST(testMultipleCommentBlocks);
   CPPUNIT_TEST(testReadPicture);
+  CPPUNIT_TEST(testReadPictureAfterSave);
+  CPPUNIT_TEST(testRemovePictureWithoutDeleting);
   CPPUNIT_TEST(testAddPicture);
   CPPUNIT_TEST(testReplacePicture);
   CPPUNIT_TEST(testRemoveAllPictures);
@@ -67,6 +69,8 @@ class TestFLAC : public CppUnit::TestFixture
   CPPUNIT_TEST(testRemoveXiphField);
   CPPUNIT_TEST(testEmptySeekTable);
   CPPUNIT_TEST(testPictureStoredAfterComment);
+  CPPUNIT_TEST(testPaddingPolicy);
+  CPPUNIT_TEST(testReadParts);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -116,6 +120,43 @@ public:
     CPPUNIT_ASSERT_EQUAL((unsigned int)150, pic->data().size());
   }
 
+  void testReadPictureAfterSave()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    // The image data is read on demand, so it has to survive a save which
+    // moves the picture block.
+
+    FLAC::File f(newname.c_str());
+    f.ID3v2Tag(true)->setTitle(longText(2048));
+    f.save();
+
+    List<FLAC::Picture *> lst = f.pictureList();
+    CPPUNIT_ASSERT_EQUAL((unsigned int)1, lst.size());
+    CPPUNIT_ASSERT_EQUAL((unsigned int)150, lst.front()->data().size());
+    CPPUNIT_ASSERT(lst.front()->data().startsWith("\x89PNG"));
+  }
+
+  void testRemovePictureWithoutDeleting()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    // A removed picture belongs to the caller and must not depend on the file.
+
+    FLAC::Picture *pic;
+    {
+      FLAC::File f(newname.c_str());
+      pic = f.pictureList().front();
+      f.removePicture(pic, false);
+      CPPUNIT_ASSERT(f.pictureList().isEmpty());
+    }
+    CPPUNIT_ASSERT_EQUAL((unsigned int)150, pic->data().size());
+    CPPUNIT_ASSERT(pic->data().startsWith("\x89PNG"));
+    delete pic;
+  }
+
   void testAddPicture()
   {
     ScopedFileCopy copy("silence-44-s", ".flac");
@@ -667,6 +708,75 @@ public:
     CPPUNIT_ASSERT(fileData.startsWith(expectedData));
   }
 
+  void testPaddingPolicy()
+  {
+    ScopedFileCopy copy("no-tags", ".flac");
+
+    // By default a padding block of 4 KiB is written behind the metadata.
+
+    long fileLength;
+    {
+      FLAC::File f(copy.fileName().c_str());
+      FLAC::Picture *picture = new FLAC::Picture();
+      picture->setData(ByteVector(4096, 'x'));
+      f.addPicture(picture);
+      f.save();
+      fileLength = f.length();
+    }
+
+    // A picture which outgrows the padding block gets the minimum padding of
+    // the policy instead.
+
+    {
+      FLAC::File f(copy.fileName().c_str());
+      f.setPaddingPolicy(16384, 16384, 1.0);
+      f.pictureList().front()->setData(ByteVector(4096 + 4097, 'x'));
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(fileLength + 4097 + 16384 - 4096, f.length());
+    }
+
+    // Padding beyond what the policy reserves is given back.
+
+    {
+      FLAC::File f(copy.fileName().c_str());
+      f.setPaddingPolicy(16384, 16384, 1.0);
+      f.pictureList().front()->setData(ByteVector(4096, 'x'));
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(fileLength + 16384 - 4096, f.length());
+    }
+    {
+      FLAC::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL((unsigned int)4096, f.pictureList().front()->data().size());
+    }
+  }
+
+  void testReadParts()
+  {
+    {
+      FLAC::File f(TEST_FILE_PATH_C("silence-44-s.flac"), ID3v2::FrameFactory::instance(),
+                   File::ReadTags | File::ReadProperties);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT(f.pictureList().isEmpty());
+    }
+    {
+      FLAC::File f(TEST_FILE_PATH_C("silence-44-s.flac"), ID3v2::FrameFactory::instance(),
+                   File::ReadPictures);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(!f.audioProperties());
+      CPPUNIT_ASSERT_EQUAL((unsigned int)1, f.pictureList().size());
+      CPPUNIT_ASSERT(f.xiphComment()->isEmpty());
+    }
+    {
+      ScopedFileCopy copy("silence-44-s", ".flac");
+      FLAC::File f(copy.fileName().c_str(), ID3v2::FrameFactory::instance(),
+                   File::ReadTags | File::ReadProperties);
+      CPPUNIT_ASSERT(!f.save());
+    }
+  }
+
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestFLAC);
@@ -67,6 +67,26 @@ class PublicFrame : public ID3v2::Frame
     virtual ByteVector renderFields() const { return ByteVector(); }
 };
 
+class CustomPrivateFrame : public ID3v2::Frame
+{
+  public:
+    CustomPrivateFrame(const ByteVector &data, Header *h) : ID3v2::Frame(h)
+      { parseFields(fieldData(data)); }
+    virtual String toString() const { return String(); }
+    virtual void parseFields(const ByteVector &data) { fields = data; }
+    virtual ByteVector renderFields() const { return fields; }
+    static ID3v2::Frame *create(const ByteVector &data, Header *h, const ID3v2::Header *)
+      { return new CustomPrivateFrame(data, h); }
+    ByteVector fields;
+};
+
+class CustomFrameFactory : public ID3v2::FrameFactory
+{
+  public:
+    CustomFrameFactory() { registerFrameType("PRIV", &CustomPrivateFrame::create); }
+    void unregister() { registerFrameType("PRIV", 0); }
+};
+
 class TestID3v2 : public CppUnit::TestFixture
 {
   CPPUNIT_TEST_SUITE(TestID3v2);
@@ -121,6 +141,7 @@ class TestID3v2 : public CppUnit::TestFixture
   CPPUNIT_TEST(testDowngradeTo23);
   // CPPUNIT_TEST(testUpdateFullDate22); TODO TYE+TDA should be upgraded to TDRC together
   CPPUNIT_TEST(testCompressedFrameWithBrokenLength);
+  CPPUNIT_TEST(testRenderCompressedFrame);
   CPPUNIT_TEST(testW000);
   CPPUNIT_TEST(testPropertyInterface);
   CPPUNIT_TEST(testPropertyInterface2);
@@ -136,6 +157,9 @@ class TestID3v2 : public CppUnit::TestFixture
   CPPUNIT_TEST(testEmptyFrame);
   CPPUNIT_TEST(testDuplicateTags);
   CPPUNIT_TEST(testParseTOCFrameWithManyChildren);
+  CPPUNIT_TEST(testRegisterFrameType);
+  CPPUNIT_TEST(testUntouchedFramesKept);
+  CPPUNIT_TEST(testUntouchedFramesDefaultEncoding);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -1060,6 +1084,46 @@ public:
     }
   }
 
+  void testRenderCompressedFrame()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    ScopedFileCopy copy("compressed_id3_frame", ".mp3");
+    string newname = copy.fileName();
+
+    {
+      MPEG::File f(newname.c_str());
+      CPPUNIT_ASSERT_EQUAL((unsigned int)1, f.ID3v2Tag()->frameList("APIC").size());
+      f.save(MPEG::File::ID3v2, File::StripOthers, ID3v2::v4);
+    }
+    {
+      MPEG::File f(newname.c_str());
+      ID3v2::AttachedPictureFrame *frame
+        = dynamic_cast<ID3v2::AttachedPictureFrame *>(f.ID3v2Tag()->frameList("APIC").front());
+      CPPUNIT_ASSERT(frame);
+      CPPUNIT_ASSERT_EQUAL((unsigned int)86414, frame->picture().size());
+      CPPUNIT_ASSERT(frame->size() < 86414);
+
+      f.seek(f.find("APIC") + 9);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\x09'), f.readBlock(1));
+
+      f.save(MPEG::File::ID3v2, File::StripOthers, ID3v2::v3);
+    }
+    {
+      MPEG::File f(newname.c_str());
+      CPPUNIT_ASSERT_EQUAL((unsigned int)3, f.ID3v2Tag()->header()->majorVersion());
+      ID3v2::AttachedPictureFrame *frame
+        = dynamic_cast<ID3v2::AttachedPictureFrame *>(f.ID3v2Tag()->frameList("APIC").front());
+      CPPUNIT_ASSERT(frame);
+      CPPUNIT_ASSERT_EQUAL(String("image/bmp"), frame->mimeType());
+      CPPUNIT_ASSERT_EQUAL((unsigned int)86414, frame->picture().size());
+
+      f.seek(f.find("APIC") + 9);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\x80'), f.readBlock(1));
+    }
+  }
+
   void testW000()
   {
     MPEG::File f(TEST_FILE_PATH_C("w000.mp3"), false);
@@ -1607,7 +1671,132 @@ public:
     CPPUNIT_ASSERT(ID3v2::TableOfContentsFrame::findByElementID(tag, "toc"));
   }
 
+
+  void testRegisterFrameType()
+  {
+    const ByteVector privData("PRIV"
+                              "\x00\x00\x00\x0e"
+                              "\x00\x00"
+                              "WM/Provider\x00"
+                              "TL", 24);
+    const ByteVector textData("TIT2"
+                              "\x00\x00\x00\x05"
+                              "\x00\x00"
+                              "\x00"
+                              "Test", 15);
+    ID3v2::Header header;
+
+    CustomFrameFactory factory;
+    ID3v2::Frame *frame = factory.createFrame(privData, &header);
+    CustomPrivateFrame *custom = dynamic_cast<CustomPrivateFrame *>(frame);
+    CPPUNIT_ASSERT(custom);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("WM/Provider\x00TL", 14), custom->fields);
+    delete frame;
+
+    frame = factory.createFrame(textData, &header);
+    CPPUNIT_ASSERT(dynamic_cast<ID3v2::TextIdentificationFrame *>(frame));
+    CPPUNIT_ASSERT_EQUAL(String("Test"), frame->toString());
+    delete frame;
+
+    frame = ID3v2::FrameFactory::instance()->createFrame(privData, &header);
+    CPPUNIT_ASSERT(dynamic_cast<ID3v2::PrivateFrame *>(frame));
+    delete frame;
+
+    factory.unregister();
+    frame = factory.createFrame(privData, &header);
+    CPPUNIT_ASSERT(dynamic_cast<ID3v2::PrivateFrame *>(frame));
+    delete frame;
+  }
+
+  void testUntouchedFramesKept()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+
+    {
+      MPEG::File f(newname.c_str());
+      f.ID3v2Tag(true)->setTitle("Title");
+      ID3v2::TextIdentificationFrame *frame =
+        new ID3v2::TextIdentificationFrame("TCOM", String::Latin1);
+      frame->setText("Composer");
+      f.ID3v2Tag()->addFrame(frame);
+      f.save();
+    }
+
+    // The global factory may have been given a default text encoding by other
+    // tests, which would make all frames be created.
+
+    CustomFrameFactory factory;
+    {
+      // Set the read only flag of TCOM, which TagLib does not render.
+      PlainFile f(newname.c_str());
+      f.seek(f.find("TCOM") + 8);
+      f.writeBlock(ByteVector(1, '\x10'));
+    }
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.ID3v2Tag()->title());
+      f.ID3v2Tag()->setTitle("New Title");
+      f.save();
+    }
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      CPPUNIT_ASSERT_EQUAL(String("New Title"), f.ID3v2Tag()->title());
+
+      const ID3v2::FrameList &frames = f.ID3v2Tag()->frameList();
+      CPPUNIT_ASSERT_EQUAL((unsigned int)2, frames.size());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("TIT2"), frames.front()->frameID());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("TCOM"), frames.back()->frameID());
+      CPPUNIT_ASSERT_EQUAL(String("Composer"), frames.back()->toString());
+
+      f.seek(f.find("TCOM") + 8);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\x10'), f.readBlock(1));
+
+      f.save(MPEG::File::AllTags, File::StripOthers, ID3v2::v4);
+    }
+    {
+      MPEG::File f(newname.c_str());
+      f.seek(f.find("TCOM") + 8);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\0'), f.readBlock(1));
+    }
+  }
+
+  void testUntouchedFramesDefaultEncoding()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+
+    CustomFrameFactory factory;
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      f.ID3v2Tag(true)->setTitle("Title");
+      ID3v2::TextIdentificationFrame *frame =
+        new ID3v2::TextIdentificationFrame("TCOM", String::Latin1);
+      frame->setText("Composer");
+      f.ID3v2Tag()->addFrame(frame);
+      f.save(MPEG::File::ID3v2, File::StripOthers, ID3v2::v4);
+    }
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      f.seek(f.find("TCOM") + 10);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\0'), f.readBlock(1));
+    }
+
+    // Frames which have not been accessed are still converted to the default
+    // text encoding.
+
+    factory.setDefaultTextEncoding(String::UTF8);
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      f.save(MPEG::File::ID3v2, File::StripOthers, ID3v2::v4);
+    }
+    {
+      MPEG::File f(newname.c_str(), &factory);
+      f.seek(f.find("TCOM") + 10);
+      CPPUNIT_ASSERT_EQUAL(ByteVector(1, '\3'), f.readBlock(1));
+      CPPUNIT_ASSERT_EQUAL(String("Composer"), f.ID3v2Tag()->frameList("TCOM").front()->toString());
+    }
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestID3v2);
-
@@ -34,6 +34,7 @@ class TestList : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(TestList);
   CPPUNIT_TEST(testAppend);
   CPPUNIT_TEST(testDetach);
+  CPPUNIT_TEST(testInsertErase);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -54,6 +55,16 @@ public:
     l3.append(4);
     CPPUNIT_ASSERT_EQUAL(4U, l1.size());
     CPPUNIT_ASSERT(l1 == l3);
+
+    l1.append(l1);
+    CPPUNIT_ASSERT_EQUAL(8U, l1.size());
+    CPPUNIT_ASSERT_EQUAL(4, l1[3]);
+    CPPUNIT_ASSERT_EQUAL(1, l1[4]);
+    l1.prepend(l1);
+    CPPUNIT_ASSERT_EQUAL(16U, l1.size());
+    CPPUNIT_ASSERT_EQUAL(4, l1[7]);
+    CPPUNIT_ASSERT_EQUAL(1, l1[8]);
+    CPPUNIT_ASSERT_EQUAL(4, l1.back());
   }
 
   void testDetach()
@@ -71,6 +82,39 @@ public:
     CPPUNIT_ASSERT_EQUAL(33, l2[2]);
   }
 
+  void testInsertErase()
+  {
+    List<int> l1;
+    for(int i = 0; i < 100; ++i)
+      l1.append(i * 2);
+
+    List<int> l2 = l1;
+    l2.sortedInsert(51);
+    l2.sortedInsert(52, true);
+    CPPUNIT_ASSERT_EQUAL(100U, l1.size());
+    CPPUNIT_ASSERT_EQUAL(101U, l2.size());
+    CPPUNIT_ASSERT_EQUAL(51, l2[26]);
+
+    for(List<int>::Iterator it = l2.begin(); it != l2.end();) {
+      if(*it % 4 == 0)
+        it = l2.erase(it);
+      else if(*it == 51)
+        it = l2.insert(it, 49) + 2;
+      else
+        ++it;
+    }
+    CPPUNIT_ASSERT_EQUAL(52U, l2.size());
+    CPPUNIT_ASSERT_EQUAL(2, l2.front());
+    CPPUNIT_ASSERT_EQUAL(49, l2[13]);
+    CPPUNIT_ASSERT_EQUAL(51, l2[14]);
+    CPPUNIT_ASSERT_EQUAL(198, l2.back());
+
+    l2.prepend(l1);
+    CPPUNIT_ASSERT_EQUAL(152U, l2.size());
+    CPPUNIT_ASSERT_EQUAL(198, l2[99]);
+    CPPUNIT_ASSERT_EQUAL(2, l2[100]);
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestList);
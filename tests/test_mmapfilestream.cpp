@@ -0,0 +1,158 @@
+/***************************************************************************
+    copyright           : (C) 2026 by the TagLib developers
+    email               : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it  under the terms of the GNU Lesser General Public License version  *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <tmmapfilestream.h>
+#include <tfilestream.h>
+#include <mpegfile.h>
+#include <id3v2framefactory.h>
+#include <tag.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "utils.h"
+
+using namespace std;
+using namespace TagLib;
+
+class TestMmapFileStream : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestMmapFileStream);
+  CPPUNIT_TEST(testReadBlock);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testWriteBlock);
+  CPPUNIT_TEST(testEmptyFile);
+  CPPUNIT_TEST(testSaveMPEG);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void testReadBlock()
+  {
+    FileStream file(TEST_FILE_PATH_C("xing.mp3"), true);
+    MmapFileStream stream(TEST_FILE_PATH_C("xing.mp3"), true);
+    CPPUNIT_ASSERT(stream.isOpen());
+    CPPUNIT_ASSERT(stream.readOnly());
+#if defined(HAVE_MMAP) || defined(_WIN32)
+    CPPUNIT_ASSERT(stream.isMapped());
+#endif
+    CPPUNIT_ASSERT_EQUAL(file.length(), stream.length());
+
+    CPPUNIT_ASSERT_EQUAL(file.readBlock(1000), stream.readBlock(1000));
+    CPPUNIT_ASSERT_EQUAL(1000L, stream.tell());
+
+    file.seek(-10, IOStream::End);
+    stream.seek(-10, IOStream::End);
+    CPPUNIT_ASSERT_EQUAL(file.readBlock(100), stream.readBlock(100));
+    CPPUNIT_ASSERT_EQUAL(stream.length(), stream.tell());
+    CPPUNIT_ASSERT(stream.readBlock(100).isEmpty());
+  }
+
+  void testSeek()
+  {
+    MmapFileStream stream(TEST_FILE_PATH_C("xing.mp3"), true);
+    stream.seek(100, IOStream::Beginning);
+    CPPUNIT_ASSERT_EQUAL(100L, stream.tell());
+    stream.seek(100, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(200L, stream.tell());
+    stream.seek(-300, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(200L, stream.tell());
+    stream.seek(-100, IOStream::End);
+    CPPUNIT_ASSERT_EQUAL(stream.length() - 100, stream.tell());
+    stream.seek(300, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(stream.length() + 200, stream.tell());
+    CPPUNIT_ASSERT(stream.readBlock(1).isEmpty());
+  }
+
+  void testWriteBlock()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string name = copy.fileName();
+
+    {
+      MmapFileStream stream(name.c_str());
+      CPPUNIT_ASSERT(!stream.readOnly());
+
+      stream.seek(10);
+      const ByteVector data = stream.readBlock(4);
+      CPPUNIT_ASSERT_EQUAL(14L, stream.tell());
+
+      stream.writeBlock(ByteVector("ABCD"));
+      CPPUNIT_ASSERT(!stream.isMapped());
+      CPPUNIT_ASSERT_EQUAL(18L, stream.tell());
+
+      stream.seek(10);
+      CPPUNIT_ASSERT_EQUAL(data + ByteVector("ABCD"), stream.readBlock(8));
+
+      stream.insert(ByteVector("XY"), 0, 0);
+      stream.seek(0);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("XY"), stream.readBlock(2));
+    }
+    {
+      FileStream file(name.c_str(), true);
+      file.seek(12);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("ABCD"), file.readBlock(8).mid(4));
+    }
+  }
+
+  void testEmptyFile()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string name = copy.fileName();
+
+    {
+      FileStream file(name.c_str());
+      file.truncate(0);
+    }
+
+    MmapFileStream stream(name.c_str());
+    CPPUNIT_ASSERT(stream.isOpen());
+    CPPUNIT_ASSERT(!stream.isMapped());
+    CPPUNIT_ASSERT_EQUAL(0L, stream.length());
+    CPPUNIT_ASSERT(stream.readBlock(10).isEmpty());
+  }
+
+  void testSaveMPEG()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string name = copy.fileName();
+
+    {
+      MmapFileStream stream(name.c_str());
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(!f.hasID3v2Tag());
+      f.tag()->setTitle("Title");
+      f.save();
+    }
+    {
+      MmapFileStream stream(name.c_str(), true);
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(f.hasID3v2Tag());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+    }
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestMmapFileStream);
@@ -52,6 +52,8 @@ class TestMP4 : public CppUnit::TestFixture
   CPPUNIT_TEST(testHasTag);
   CPPUNIT_TEST(testIsEmpty);
   CPPUNIT_TEST(testUpdateStco);
+  CPPUNIT_TEST(testUpdateFragmentOffsets);
+  CPPUNIT_TEST(testUpdateSegmentIndexVersion1);
   CPPUNIT_TEST(testSaveExisingWhenIlstIsLast);
   CPPUNIT_TEST(test64BitAtom);
   CPPUNIT_TEST(testGnre);
@@ -65,6 +67,9 @@ class TestMP4 : public CppUnit::TestFixture
   CPPUNIT_TEST(testRepeatedSave);
   CPPUNIT_TEST(testWithZeroLengthAtom);
   CPPUNIT_TEST(testEmptyValuesRemoveItems);
+  CPPUNIT_TEST(testPaddingPolicy);
+  CPPUNIT_TEST(testMoveMetadataToEnd);
+  CPPUNIT_TEST(testReadParts);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -243,6 +248,152 @@ public:
     }
   }
 
+  static ByteVector atom(const char *name, const ByteVector &data)
+  {
+    return ByteVector::fromUInt(data.size() + 8) + ByteVector(name, 4) + data;
+  }
+
+  void testUpdateFragmentOffsets()
+  {
+    // A fragmented file with two 'moof' atoms, indexed by 'sidx' and 'mfra'.
+
+    const ByteVector ftyp = atom("ftyp", ByteVector("isom") + ByteVector(4, '\0') + ByteVector("isom"));
+    const long moovSize = 8 + 8 + 8 + 8 + 8 + 20;
+    const long sidxSize = 8 + 36;
+    const long moof1 = ftyp.size() + moovSize + sidxSize;
+    const long moofSize = 8 + 8 + 24;
+    const long mdat1 = moof1 + moofSize;
+    const long moof2 = mdat1 + 12;
+    const long mdat2 = moof2 + moofSize;
+
+    const ByteVector stco = atom("stco", ByteVector::fromUInt(0) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(mdat1 + 8));
+    const ByteVector moov = atom("moov", atom("trak", atom("mdia", atom("minf", atom("stbl", stco)))));
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(moovSize), moov.size());
+
+    const ByteVector sidx = atom("sidx", ByteVector::fromUInt(0) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(1000) + ByteVector::fromUInt(0) +
+                                         ByteVector::fromUInt(0) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(moof2 - moof1) +
+                                         ByteVector::fromUInt(1000) + ByteVector::fromUInt(0x90000000));
+
+    ByteVector data = ftyp + moov + sidx;
+    for(int i = 0; i < 2; ++i) {
+      const long mdat = (i == 0) ? mdat1 : mdat2;
+      const ByteVector tfhd = atom("tfhd", ByteVector::fromUInt(1) + ByteVector::fromUInt(1) +
+                                           ByteVector::fromLongLong(mdat + 8));
+      data.append(atom("moof", atom("traf", tfhd)));
+      data.append(atom("mdat", ByteVector(4, 'A' + i)));
+    }
+
+    ByteVector tfra = ByteVector::fromUInt(0x01000000) + ByteVector::fromUInt(1) +
+                      ByteVector::fromUInt(0) + ByteVector::fromUInt(2);
+    tfra.append(ByteVector::fromLongLong(0) + ByteVector::fromLongLong(moof1) + ByteVector(3, '\1'));
+    tfra.append(ByteVector::fromLongLong(1000) + ByteVector::fromLongLong(moof2) + ByteVector(3, '\1'));
+    const ByteVector mfro = atom("mfro", ByteVector::fromUInt(0) + ByteVector::fromUInt(8 + 8 + tfra.size() + 16));
+    data.append(atom("mfra", atom("tfra", tfra) + mfro));
+
+    ByteVectorStream stream(data);
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      f.tag()->setTitle("Title");
+      f.save();
+    }
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+
+      MP4::Atoms a(&f);
+      CPPUNIT_ASSERT_EQUAL(8U, a.atoms.size());
+
+      const long delta = static_cast<long>(stream.length()) - static_cast<long>(data.size());
+      CPPUNIT_ASSERT(delta > 0);
+      CPPUNIT_ASSERT_EQUAL(moof1 + delta, a.atoms[3]->offset);
+      CPPUNIT_ASSERT_EQUAL(moof2 + delta, a.atoms[5]->offset);
+
+      // 'stco' and 'tfhd' point to the media data.
+
+      MP4::Atom *stcoAtom = a.find("moov")->findall("stco", true)[0];
+      f.seek(stcoAtom->offset + 16);
+      f.seek(f.readBlock(4).toUInt());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("AAAA"), f.readBlock(4));
+
+      for(int i = 0; i < 2; ++i) {
+        MP4::Atom *tfhdAtom = a.atoms[3 + i * 2]->findall("tfhd", true)[0];
+        f.seek(tfhdAtom->offset + 16);
+        f.seek(f.readBlock(8).toLongLong());
+        CPPUNIT_ASSERT_EQUAL(ByteVector(4, 'A' + i), f.readBlock(4));
+      }
+
+      // 'sidx' and 'mfra' point to the 'moof' atoms.
+
+      CPPUNIT_ASSERT_EQUAL(moof1 + delta, a.atoms[2]->offset + a.atoms[2]->length);
+      f.seek(a.atoms[2]->offset + 24);
+      CPPUNIT_ASSERT_EQUAL(0U, f.readBlock(4).toUInt());
+
+      f.seek(a.atoms[7]->offset + 8 + 8 + 16);
+      ByteVector entries = f.readBlock(38);
+      CPPUNIT_ASSERT_EQUAL(moof1 + delta, static_cast<long>(entries.toLongLong(8U)));
+      CPPUNIT_ASSERT_EQUAL(moof2 + delta, static_cast<long>(entries.toLongLong(27U)));
+    }
+  }
+
+  void testUpdateSegmentIndexVersion1()
+  {
+    // A version 1 'sidx' atom in front of 'moov', so its 64-bit first offset
+    // spans the inserted data.
+
+    const ByteVector ftyp = atom("ftyp", ByteVector("isom") + ByteVector(4, '\0') + ByteVector("isom"));
+    const long sidxSize = 8 + 44;
+    const long moovSize = 8 + 8 + 8 + 8 + 8 + 20;
+    const long moof = ftyp.size() + sidxSize + moovSize;
+    const long mdat = moof + 8 + 8 + 24;
+
+    const ByteVector sidx = atom("sidx", ByteVector::fromUInt(0x01000000) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(1000) + ByteVector::fromLongLong(0) +
+                                         ByteVector::fromLongLong(moovSize) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(mdat + 12 - moof) +
+                                         ByteVector::fromUInt(1000) + ByteVector::fromUInt(0x90000000));
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(sidxSize), sidx.size());
+
+    const ByteVector stco = atom("stco", ByteVector::fromUInt(0) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromUInt(mdat + 8));
+    const ByteVector moov = atom("moov", atom("trak", atom("mdia", atom("minf", atom("stbl", stco)))));
+    const ByteVector tfhd = atom("tfhd", ByteVector::fromUInt(1) + ByteVector::fromUInt(1) +
+                                         ByteVector::fromLongLong(mdat + 8));
+
+    const ByteVector data = ftyp + sidx + moov + atom("moof", atom("traf", tfhd)) +
+                            atom("mdat", ByteVector("AAAA"));
+
+    ByteVectorStream stream(data);
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      f.tag()->setTitle("Title");
+      f.save();
+    }
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+
+      MP4::Atoms a(&f);
+      CPPUNIT_ASSERT_EQUAL(5U, a.atoms.size());
+
+      const long delta = static_cast<long>(stream.length()) - static_cast<long>(data.size());
+      CPPUNIT_ASSERT(delta > 0);
+      CPPUNIT_ASSERT_EQUAL(moof + delta, a.atoms[3]->offset);
+
+      f.seek(a.atoms[1]->offset + 8 + 20);
+      const long long firstOffset = f.readBlock(8).toLongLong();
+      CPPUNIT_ASSERT_EQUAL(static_cast<long long>(moovSize + delta), firstOffset);
+      CPPUNIT_ASSERT_EQUAL(a.atoms[3]->offset,
+                           static_cast<long>(a.atoms[1]->offset + a.atoms[1]->length + firstOffset));
+    }
+  }
+
   void testFreeForm()
   {
     ScopedFileCopy copy("has-tags", ".m4a");
@@ -654,6 +805,149 @@ public:
     CPPUNIT_ASSERT_EQUAL(zeroUInt, tag->track());
     CPPUNIT_ASSERT(!tag->contains("trkn"));
   }
+  void testPaddingPolicy()
+  {
+    ScopedFileCopy copy("has-tags", ".m4a");
+
+    long fileLength;
+    {
+      MP4::File f(copy.fileName().c_str());
+      f.tag()->setTitle(longText(8192));
+      f.save();
+      fileLength = f.length();
+    }
+
+    // Shrinking the 'free' atom would move the media data, so by default the
+    // space of a smaller tag is kept as padding...
+
+    {
+      MP4::File f(copy.fileName().c_str());
+      f.tag()->setTitle("Title");
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(fileLength, f.length());
+    }
+
+    // ...unless a padding policy has been set.
+
+    {
+      MP4::File f(copy.fileName().c_str());
+      f.setPaddingPolicy(0, 1024 * 1024, 1.0);
+      f.tag()->setTitle("Title");
+      f.save();
+      CPPUNIT_ASSERT(f.length() < fileLength - 7000);
+    }
+    {
+      MP4::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+      CPPUNIT_ASSERT_EQUAL(3708, f.audioProperties()->lengthInMilliseconds());
+    }
+  }
+
+  void testMoveMetadataToEnd()
+  {
+    // A file whose 'mdat' atom follows the 'moov' atom.
+
+    ByteVector data;
+    {
+      MP4::File f(TEST_FILE_PATH_C("zero-length-mdat.m4a"));
+      f.seek(0);
+      data = f.readBlock(f.length());
+    }
+    const ByteVector mdat = ByteVector::fromUInt(data.size() - 1389) + ByteVector("mdat");
+    data = data.mid(0, 1389) + mdat + data.mid(1397);
+
+    ByteVectorStream stream(data);
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT_EQUAL(MP4::File::InsertMetadata, f.saveStrategy());
+      f.setSaveStrategy(MP4::File::MoveMetadataToEnd);
+      f.tag()->setTitle(longText(4096));
+      f.save();
+      CPPUNIT_ASSERT(f.hasMP4Tag());
+    }
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(longText(4096), f.tag()->title());
+      CPPUNIT_ASSERT_EQUAL(1115, f.audioProperties()->lengthInMilliseconds());
+
+      // The media data has not moved, and the old 'moov' atom is free space.
+
+      MP4::Atoms a(&f);
+      CPPUNIT_ASSERT_EQUAL(5U, a.atoms.size());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("free"), a.atoms[1]->name);
+      CPPUNIT_ASSERT_EQUAL(32L, a.atoms[1]->offset);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("mdat"), a.atoms[3]->name);
+      CPPUNIT_ASSERT_EQUAL(1389L, a.atoms[3]->offset);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("moov"), a.atoms[4]->name);
+      CPPUNIT_ASSERT_EQUAL(data.mid(1389), stream.data()->mid(1389, data.size() - 1389));
+
+      MP4::Atom *stco = a.find("moov")->findall("stco", true)[0];
+      f.seek(stco->offset + 16);
+      CPPUNIT_ASSERT(f.readBlock(4).toUInt() > 1389U);
+
+      // The 'moov' atom is the last one now, so it grows in place.
+
+      f.setSaveStrategy(MP4::File::MoveMetadataToEnd);
+      f.tag()->setTitle(longText(8192));
+      f.save();
+    }
+    {
+      MP4::File f(&stream);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(longText(8192), f.tag()->title());
+
+      MP4::Atoms a(&f);
+      CPPUNIT_ASSERT_EQUAL(5U, a.atoms.size());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("moov"), a.atoms[4]->name);
+      CPPUNIT_ASSERT_EQUAL(a.atoms[4]->offset + a.atoms[4]->length, f.length());
+    }
+
+    // Data which follows the last atom, like an ID3v1 tag, would hide an
+    // appended 'moov' atom, so the metadata is inserted in place.
+
+    const ByteVector trailer = ByteVector("TAG") + ByteVector(125, ' ');
+    ByteVectorStream trailed(data + trailer);
+    {
+      MP4::File f(&trailed);
+      f.setSaveStrategy(MP4::File::MoveMetadataToEnd);
+      f.tag()->setTitle(longText(4096));
+      f.save();
+    }
+    {
+      MP4::File f(&trailed);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT_EQUAL(longText(4096), f.tag()->title());
+      CPPUNIT_ASSERT_EQUAL(1115, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("moov"), MP4::Atoms(&f).atoms[1]->name);
+      CPPUNIT_ASSERT(trailed.data()->endsWith(trailer));
+    }
+  }
+
+  void testReadParts()
+  {
+    {
+      MP4::File f(TEST_FILE_PATH_C("has-tags.m4a"), File::ReadTags | File::ReadProperties);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT(f.tag()->contains("\251ART"));
+      CPPUNIT_ASSERT(!f.tag()->contains("covr"));
+    }
+    {
+      MP4::File f(TEST_FILE_PATH_C("has-tags.m4a"), File::ReadPictures);
+      CPPUNIT_ASSERT(f.isValid());
+      CPPUNIT_ASSERT(!f.audioProperties());
+      CPPUNIT_ASSERT(f.tag()->isEmpty());
+    }
+    {
+      ScopedFileCopy copy("has-tags", ".m4a");
+      MP4::File f(copy.fileName().c_str(), File::ReadTags);
+      f.tag()->setTitle("Title");
+      CPPUNIT_ASSERT(!f.save());
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMP4);
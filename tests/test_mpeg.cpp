@@ -29,11 +29,13 @@
 #include <tpropertymap.h>
 #include <mpegfile.h>
 #include <id3v2tag.h>
+#include <id3v2header.h>
 #include <id3v1tag.h>
 #include <apetag.h>
 #include <mpegproperties.h>
 #include <xingheader.h>
 #include <mpegheader.h>
+#include <tbytevectorstream.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
 
@@ -46,7 +48,10 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testAudioPropertiesXingHeaderCBR);
   CPPUNIT_TEST(testAudioPropertiesXingHeaderVBR);
   CPPUNIT_TEST(testAudioPropertiesVBRIHeader);
+  CPPUNIT_TEST(testXingTableOfContents);
+  CPPUNIT_TEST(testLAMETag);
   CPPUNIT_TEST(testAudioPropertiesNoVBRHeaders);
+  CPPUNIT_TEST(testAudioPropertiesAccurate);
   CPPUNIT_TEST(testSkipInvalidFrames1);
   CPPUNIT_TEST(testSkipInvalidFrames2);
   CPPUNIT_TEST(testSkipInvalidFrames3);
@@ -57,6 +62,7 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testDuplicateID3v2);
   CPPUNIT_TEST(testFuzzedFile);
   CPPUNIT_TEST(testFrameOffset);
+  CPPUNIT_TEST(testFrameOffsetAfterJunk);
   CPPUNIT_TEST(testStripAndProperties);
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testRepeatedSave1);
@@ -66,6 +72,7 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testEmptyID3v1);
   CPPUNIT_TEST(testEmptyAPE);
   CPPUNIT_TEST(testIgnoreGarbage);
+  CPPUNIT_TEST(testPaddingPolicy);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -106,6 +113,54 @@ public:
     CPPUNIT_ASSERT_EQUAL(MPEG::XingHeader::VBRI, f.audioProperties()->xingHeader()->type());
   }
 
+  void testXingTableOfContents()
+  {
+    {
+      MPEG::File f(TEST_FILE_PATH_C("lame_vbr.mp3"));
+      const MPEG::XingHeader *xingHeader = f.audioProperties()->xingHeader();
+      CPPUNIT_ASSERT(xingHeader->hasTableOfContents());
+      CPPUNIT_ASSERT_EQUAL(50, xingHeader->quality());
+      CPPUNIT_ASSERT_EQUAL(0L, xingHeader->seekOffset(0));
+      CPPUNIT_ASSERT_EQUAL(8289308L, xingHeader->seekOffset(943583));
+      CPPUNIT_ASSERT_EQUAL(16578604L, xingHeader->seekOffset(1887164 * 2));
+    }
+    {
+      MPEG::File f(TEST_FILE_PATH_C("rare_frames.mp3"));
+      const MPEG::XingHeader *xingHeader = f.audioProperties()->xingHeader();
+      CPPUNIT_ASSERT(!xingHeader->hasTableOfContents());
+      CPPUNIT_ASSERT_EQUAL(-1, xingHeader->quality());
+      CPPUNIT_ASSERT_EQUAL(-1L, xingHeader->seekOffset(0));
+    }
+  }
+
+  void testLAMETag()
+  {
+    {
+      MPEG::File f(TEST_FILE_PATH_C("lame_vbr.mp3"));
+      const MPEG::XingHeader *xingHeader = f.audioProperties()->xingHeader();
+      CPPUNIT_ASSERT(xingHeader->hasLAMETag());
+      CPPUNIT_ASSERT_EQUAL(String("LAME3.99r"), xingHeader->encoderVersion());
+      CPPUNIT_ASSERT_EQUAL(4, xingHeader->vbrMethod());
+      CPPUNIT_ASSERT_EQUAL(17000, xingHeader->lowpassFilter());
+      CPPUNIT_ASSERT_EQUAL(576, xingHeader->encoderDelay());
+      CPPUNIT_ASSERT_EQUAL(576, xingHeader->encoderPadding());
+    }
+    {
+      MPEG::File f(TEST_FILE_PATH_C("lame_cbr.mp3"));
+      const MPEG::XingHeader *xingHeader = f.audioProperties()->xingHeader();
+      CPPUNIT_ASSERT(xingHeader->hasLAMETag());
+      CPPUNIT_ASSERT_EQUAL(1, xingHeader->vbrMethod());
+      CPPUNIT_ASSERT_EQUAL(16500, xingHeader->lowpassFilter());
+    }
+    {
+      MPEG::File f(TEST_FILE_PATH_C("rare_frames.mp3"));
+      const MPEG::XingHeader *xingHeader = f.audioProperties()->xingHeader();
+      CPPUNIT_ASSERT(!xingHeader->hasLAMETag());
+      CPPUNIT_ASSERT_EQUAL(String(), xingHeader->encoderVersion());
+      CPPUNIT_ASSERT_EQUAL(0, xingHeader->encoderDelay());
+    }
+  }
+
   void testAudioPropertiesNoVBRHeaders()
   {
     MPEG::File f(TEST_FILE_PATH_C("bladeenc.mp3"));
@@ -124,6 +179,49 @@ public:
     CPPUNIT_ASSERT_EQUAL(209, lastHeader.frameLength());
   }
 
+  void testAudioPropertiesAccurate()
+  {
+    // A VBR stream without the frame containing its Xing header.
+
+    ByteVector data;
+    {
+      MPEG::File f(TEST_FILE_PATH_C("lame_vbr.mp3"));
+      const long first = f.firstFrameOffset();
+      const MPEG::Header firstHeader(&f, first, false);
+
+      f.seek(0);
+      data = f.readBlock(first);
+      f.seek(first + firstHeader.frameLength());
+      data.append(f.readBlock(f.length()));
+    }
+    ByteVectorStream stream(data);
+    {
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance(), true, MPEG::Properties::Average);
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT(!f.audioProperties()->xingHeader());
+      CPPUNIT_ASSERT_EQUAL(98, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(160, f.audioProperties()->bitrate());
+      CPPUNIT_ASSERT(f.audioProperties()->seekTable().isEmpty());
+    }
+    {
+      MPEG::File f(&stream, ID3v2::FrameFactory::instance(), true, MPEG::Properties::Accurate);
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT_EQUAL(209, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(75, f.audioProperties()->bitrate());
+      CPPUNIT_ASSERT_EQUAL(1U, f.audioProperties()->seekTable().size());
+      CPPUNIT_ASSERT_EQUAL(f.firstFrameOffset(), f.audioProperties()->seekTable().front());
+    }
+    {
+      MPEG::File f(TEST_FILE_PATH_C("bladeenc.mp3"), ID3v2::FrameFactory::instance(),
+                   true, MPEG::Properties::Accurate);
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT_EQUAL(3553, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(64, f.audioProperties()->bitrate());
+      CPPUNIT_ASSERT_EQUAL(2U, f.audioProperties()->seekTable().size());
+      CPPUNIT_ASSERT_EQUAL(0L, f.audioProperties()->seekTable()[0]);
+    }
+  }
+
   void testSkipInvalidFrames1()
   {
     MPEG::File f(TEST_FILE_PATH_C("invalid-frames1.mp3"));
@@ -273,6 +371,40 @@ public:
     }
   }
 
+  void testFrameOffsetAfterJunk()
+  {
+    long firstFrameOffset;
+    long lastFrameOffset;
+    ByteVector data;
+    {
+      MPEG::File f(TEST_FILE_PATH_C("xing.mp3"));
+      firstFrameOffset = f.firstFrameOffset();
+      lastFrameOffset  = f.lastFrameOffset();
+      f.seek(0);
+      data = f.readBlock(f.length());
+    }
+
+    // Put the first frame header across the boundary of the 1024 byte buffers,
+    // after some bytes which look like frame headers but are not followed by
+    // a consistent frame.
+
+    const ByteVector header("\xFF\xFB\x10\x64", 4);
+    ByteVector junk;
+    junk.append(header).append(ByteVector(496, '\0'));
+    junk.append(header).append(ByteVector(515, '\0'));
+    junk.append(header);
+    CPPUNIT_ASSERT_EQUAL(1023U, junk.size());
+
+    ByteVectorStream stream(junk + data);
+    MPEG::File f(&stream, ID3v2::FrameFactory::instance());
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT(!f.hasID3v2Tag());
+    CPPUNIT_ASSERT_EQUAL(firstFrameOffset + 1023, f.firstFrameOffset());
+    CPPUNIT_ASSERT_EQUAL(lastFrameOffset + 1023, f.lastFrameOffset());
+    CPPUNIT_ASSERT_EQUAL(1023L, f.nextFrameOffset(1));
+    CPPUNIT_ASSERT_EQUAL(-1L, f.previousFrameOffset(1023));
+  }
+
   void testStripAndProperties()
   {
     ScopedFileCopy copy("xing", ".mp3");
@@ -534,6 +666,46 @@ public:
     }
   }
 
+  void testPaddingPolicy()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+
+    // The padding of a growing ID3v2 tag is growthFactor - 1 times the size
+    // of its frames, clamped to the maximum.
+
+    {
+      MPEG::File f(copy.fileName().c_str());
+      f.setPaddingPolicy(0, 2048, 4.0);
+      f.ID3v2Tag(true)->setTitle(longText(4096));
+      f.save();
+    }
+    {
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT_EQUAL(4107U + 2048U, f.ID3v2Tag()->header()->tagSize());
+      f.setPaddingPolicy(0, 1024 * 1024, 2.0);
+      f.ID3v2Tag()->setTitle(longText(8000));
+      f.save();
+    }
+
+    // A tag which fits into the padding is written in place.
+
+    long fileLength;
+    {
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT_EQUAL(8011U * 2, f.ID3v2Tag()->header()->tagSize());
+      fileLength = f.length();
+      f.setPaddingPolicy(0, 1024 * 1024, 2.0);
+      f.ID3v2Tag()->setTitle(longText(9000));
+      f.save();
+      CPPUNIT_ASSERT_EQUAL(fileLength, f.length());
+    }
+    {
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT_EQUAL(8011U * 2, f.ID3v2Tag()->header()->tagSize());
+      CPPUNIT_ASSERT_EQUAL(longText(9000), f.ID3v2Tag()->title());
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMPEG);
@@ -31,6 +31,8 @@
 #include <tpropertymap.h>
 #include <oggfile.h>
 #include <vorbisfile.h>
+#include <opusfile.h>
+#include <oggpage.h>
 #include <oggpageheader.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
@@ -49,6 +51,8 @@ class TestOGG : public CppUnit::TestFixture
   CPPUNIT_TEST(testAudioProperties);
   CPPUNIT_TEST(testPageChecksum);
   CPPUNIT_TEST(testPageGranulePosition);
+  CPPUNIT_TEST(testFindGranulePosition);
+  CPPUNIT_TEST(testLastPageOfMultiplexedStream);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -250,6 +254,79 @@ public:
       CPPUNIT_ASSERT_EQUAL(static_cast<long long>(0), f.readBlock(8).toLongLong());
     }
   }
+
+  void testFindGranulePosition()
+  {
+    {
+      Vorbis::File f(TEST_FILE_PATH_C("empty.ogg"));
+      CPPUNIT_ASSERT_EQUAL(0L, f.findGranulePosition(0));
+      CPPUNIT_ASSERT_EQUAL(3979L, f.findGranulePosition(1));
+      CPPUNIT_ASSERT_EQUAL(3979L, f.findGranulePosition(162496));
+      CPPUNIT_ASSERT_EQUAL(-1L, f.findGranulePosition(162497));
+      CPPUNIT_ASSERT_EQUAL(2, f.lastPageHeader()->pageSequenceNumber());
+    }
+
+    ScopedFileCopy copy("empty", ".ogg");
+    {
+      Vorbis::File f(copy.fileName().c_str());
+      f.tag()->setComment(String(ByteVector(70000, 'A')));
+      f.save();
+    }
+    {
+      // The pages of the comment packet have no granule position and must be
+      // skipped.
+      Vorbis::File f(copy.fileName().c_str());
+      const long offset = f.findGranulePosition(1);
+      CPPUNIT_ASSERT(offset > 70000);
+
+      const Ogg::Page page(&f, offset);
+      CPPUNIT_ASSERT_EQUAL(162496LL, page.header()->absoluteGranularPosition());
+      CPPUNIT_ASSERT(page.header()->lastPageOfStream());
+      CPPUNIT_ASSERT_EQUAL(0L, f.findGranulePosition(0));
+    }
+    {
+      // The target is several pages past the indexed ones.
+      Ogg::Opus::File f(TEST_FILE_PATH_C("correctness_gain_silent_output.opus"));
+      CPPUNIT_ASSERT_EQUAL(2956L, f.findGranulePosition(40000));
+      CPPUNIT_ASSERT_EQUAL(30096L, f.findGranulePosition(366480));
+      CPPUNIT_ASSERT_EQUAL(374L, f.findGranulePosition(33720));
+      CPPUNIT_ASSERT_EQUAL(34893L, f.findGranulePosition(366481));
+      CPPUNIT_ASSERT_EQUAL(-1L, f.findGranulePosition(371490));
+    }
+    {
+      Ogg::Opus::File f(TEST_FILE_PATH_C("correctness_gain_silent_output.opus"));
+      CPPUNIT_ASSERT_EQUAL(12025L, f.findGranulePosition(130000));
+    }
+  }
+
+
+  void testLastPageOfMultiplexedStream()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    {
+      // Append a page of another stream and something which looks like a page.
+      ByteVectorList packets;
+      packets.append(ByteVector(100, 'x'));
+      List<Ogg::Page *> pages = Ogg::Page::paginate(packets, Ogg::Page::SinglePagePerGroup, 1234, 0);
+      pages.setAutoDelete(true);
+
+      Vorbis::File f(copy.fileName().c_str());
+      f.seek(0, File::End);
+      f.writeBlock(pages.front()->render());
+      f.writeBlock(ByteVector("OggS\0\0garbage", 14));
+    }
+    {
+      Vorbis::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT_EQUAL(162496LL, f.lastPageHeader()->absoluteGranularPosition());
+      CPPUNIT_ASSERT_EQUAL(3685, f.audioProperties()->lengthInMilliseconds());
+
+      const Map<unsigned int, long long> positions = f.lastGranulePositions();
+      CPPUNIT_ASSERT_EQUAL(2U, positions.size());
+      CPPUNIT_ASSERT_EQUAL(162496LL, positions[f.firstPageHeader()->streamSerialNumber()]);
+      CPPUNIT_ASSERT_EQUAL(0LL, positions[1234]);
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestOGG);
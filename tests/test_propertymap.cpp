@@ -36,6 +36,7 @@ class TestPropertyMap : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(TestPropertyMap);
   CPPUNIT_TEST(testInvalidKeys);
   CPPUNIT_TEST(testGetSet);
+  CPPUNIT_TEST(testCaseInsensitiveKeys);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -109,6 +110,42 @@ public:
     CPPUNIT_ASSERT_EQUAL(0U, tag.track());
   }
 
+  void testCaseInsensitiveKeys()
+  {
+    PropertyMap map;
+    map.insert("title", StringList("Title"));
+    map.insert("TiTlE", StringList("Title 2"));
+    map.insert("custom_key", StringList("Custom"));
+    map["Artist"].append("Artist");
+    map["MusicBrainz_TrackId"].append("ID");
+
+    CPPUNIT_ASSERT_EQUAL(4u, map.size());
+    CPPUNIT_ASSERT_EQUAL(String("ARTIST"), map.begin()->first);
+    CPPUNIT_ASSERT_EQUAL(String("TITLE"), map.find("title")->first);
+    CPPUNIT_ASSERT_EQUAL(StringList(StringList("Title")).append("Title 2"), map["Title"]);
+    CPPUNIT_ASSERT(map.contains("CUSTOM_KEY"));
+    CPPUNIT_ASSERT(map.contains("Custom_Key"));
+    CPPUNIT_ASSERT(map.find("custom_key") != map.end());
+    CPPUNIT_ASSERT_EQUAL(String("ARTIST"), map.find("artist")->first);
+    CPPUNIT_ASSERT(map.contains("MUSICBRAINZ_TRACKID"));
+    CPPUNIT_ASSERT(!map.contains("TITLES"));
+    CPPUNIT_ASSERT(!map.contains("TITL"));
+
+    map["acoustid_fingerprint"].append("Fingerprint");
+    map["work"].append("Work");
+    CPPUNIT_ASSERT_EQUAL(String("ACOUSTID_FINGERPRINT"), map.begin()->first);
+    CPPUNIT_ASSERT_EQUAL(String("WORK"), (--map.end())->first);
+    map.erase("ACOUSTID_FINGERPRINT");
+    map.erase("Work");
+
+    map.replace("custom_KEY", StringList("Replaced"));
+    CPPUNIT_ASSERT_EQUAL(String("Replaced"), map["CUSTOM_KEY"].front());
+
+    map.erase("Title");
+    CPPUNIT_ASSERT(!map.contains("TITLE"));
+    CPPUNIT_ASSERT_EQUAL(3u, map.size());
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestPropertyMap);
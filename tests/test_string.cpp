@@ -52,6 +52,8 @@ class TestString : public CppUnit::TestFixture
   CPPUNIT_TEST(testEncodeNonBMP);
   CPPUNIT_TEST(testIterator);
   CPPUNIT_TEST(testInvalidUTF8);
+  CPPUNIT_TEST(testKeepUTF8);
+  CPPUNIT_TEST(testLongText);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -365,6 +367,99 @@ public:
     CPPUNIT_ASSERT(String(ByteVector("\xED\xB0\x80\xED\xA0\x80"), String::UTF8).isEmpty());
   }
 
+  void testKeepUTF8()
+  {
+    const String jpn(ByteVector("\xE6\x97\xA5\xE6\x9C\xAC\0\xE8\xAA\x9E", 10), String::UTF8);
+    CPPUNIT_ASSERT_EQUAL(String(L"\u65E5\u672C"), jpn);
+    CPPUNIT_ASSERT_EQUAL(std::string("\xE6\x97\xA5\xE6\x9C\xAC"), std::string(jpn.toCString(true)));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xE6\x97\xA5\xE6\x9C\xAC"), jpn.data(String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(std::string("\xE5\x2C"), jpn.to8Bit(false));
+
+    String s1("\xC3\xA4" "bc", String::UTF8);
+    const String s2 = s1;
+    s1[1] = L'x';
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4xc"), s1.to8Bit(true));
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4" "bc"), s2.to8Bit(true));
+
+    s1 += "d";
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4xcd"), std::string(s1.toCString(true)));
+    s1 += "e";
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4xcde"), std::string(s1.toCString(true)));
+
+    // Writes through references taken before toCString() must show up in the
+    // UTF-8 data.
+
+    String s3("abc", String::UTF8);
+    String::Iterator it = s3.begin();
+    wchar_t &c = s3[1];
+    CPPUNIT_ASSERT_EQUAL(std::string("abc"), std::string(s3.toCString(true)));
+    *it = L'\u00E4';
+    c = L'x';
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4xc"), s3.to8Bit(true));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xC3\xA4xc"), s3.data(String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(std::string("\xC3\xA4xc"), std::string(s3.toCString(true)));
+
+    const String invalid(std::string("\xC3"), String::UTF8);
+    CPPUNIT_ASSERT(invalid.isEmpty());
+    CPPUNIT_ASSERT_EQUAL(std::string(), invalid.to8Bit(true));
+  }
+
+  void testLongText()
+  {
+    // Long enough to be converted in blocks, with characters of every length
+    // spanning the block boundaries.
+
+    std::wstring units;
+    std::string utf8;
+    for(int i = 0; i < 40; ++i) {
+      for(int j = 0; j < i % 19; ++j) {
+        units += static_cast<wchar_t>(L'a' + j);
+        utf8  += static_cast<char>('a' + j);
+      }
+      switch(i % 4) {
+      case 0:
+        units += L'\u00E9';
+        utf8  += "\xC3\xA9";
+        break;
+      case 1:
+        units += L'\u65E5';
+        utf8  += "\xE6\x97\xA5";
+        break;
+      case 2:
+        units += static_cast<wchar_t>(0xD83C);
+        units += static_cast<wchar_t>(0xDD50);
+        utf8  += "\xF0\x9F\x85\x90";
+        break;
+      }
+    }
+
+    const String s(utf8, String::UTF8);
+    CPPUNIT_ASSERT(s.toWString() == units);
+    CPPUNIT_ASSERT_EQUAL(ByteVector(utf8.data(), static_cast<unsigned int>(utf8.size())),
+                         String(units).data(String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(s, String(s.data(String::UTF16), String::UTF16));
+    CPPUNIT_ASSERT_EQUAL(s, String(s.data(String::UTF16LE), String::UTF16LE));
+    CPPUNIT_ASSERT_EQUAL(s, String(s.data(String::UTF16BE), String::UTF16BE));
+
+    const ByteVector be = s.data(String::UTF16BE);
+    CPPUNIT_ASSERT_EQUAL('\xD8', be[2 * units.find(static_cast<wchar_t>(0xD83C))]);
+
+    ByteVector latin1;
+    for(int i = 1; i < 256; ++i)
+      latin1.append(static_cast<char>(i));
+    const String l(latin1, String::Latin1);
+    CPPUNIT_ASSERT_EQUAL(255U, l.size());
+    CPPUNIT_ASSERT_EQUAL(L'\u00FF', l[254]);
+    CPPUNIT_ASSERT_EQUAL(latin1, l.data(String::Latin1));
+
+    const std::string ascii(40, 'x');
+    CPPUNIT_ASSERT(String(ascii + "\xC0\xAF" + ascii, String::UTF8).isEmpty());
+    CPPUNIT_ASSERT(String(ascii + "\xED\xA0\x80" + ascii, String::UTF8).isEmpty());
+    CPPUNIT_ASSERT(String(ascii + "\xE6\x97", String::UTF8).isEmpty());
+    CPPUNIT_ASSERT(String(std::wstring(40, L'x') + static_cast<wchar_t>(0xDD50) + std::wstring(40, L'x'))
+                   .data(String::UTF8).isEmpty());
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestString);
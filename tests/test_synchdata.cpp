@@ -42,6 +42,7 @@ class TestID3v2SynchData : public CppUnit::TestFixture
   CPPUNIT_TEST(testDecode2);
   CPPUNIT_TEST(testDecode3);
   CPPUNIT_TEST(testDecode4);
+  CPPUNIT_TEST(testDecode5);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -122,6 +123,16 @@ public:
     CPPUNIT_ASSERT_EQUAL(ByteVector("\xff\xff\xff", 3), a);
   }
 
+  void testDecode5()
+  {
+    ByteVector a("\x01\xff\x00\x00\xff\xff\x00\xff\x00\x02\xff", 11);
+    a = ID3v2::SynchData::decode(a);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\x01\xff\x00\xff\xff\xff\x02\xff", 8), a);
+
+    const ByteVector b("\xff\x01\x02\xff", 4);
+    CPPUNIT_ASSERT_EQUAL(b, ID3v2::SynchData::decode(b));
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestID3v2SynchData);
@@ -0,0 +1,158 @@
+/***************************************************************************
+    copyright           : (C) 2026 by the TagLib developers
+    email               : taglib-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it  under the terms of the GNU Lesser General Public License version  *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include <tbytevector.h>
+#include <tzlib.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace std;
+using namespace TagLib;
+
+namespace
+{
+  // Compressible data which still needs several blocks of output.
+
+  ByteVector testData()
+  {
+    ByteVector data(100000, '\0');
+    for(unsigned int i = 0; i < data.size(); ++i)
+      data[i] = static_cast<char>('a' + (i * i + i / 7) % 26);
+    return data;
+  }
+}
+
+class TestZLib : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestZLib);
+  CPPUNIT_TEST(testInflateInPieces);
+  CPPUNIT_TEST(testInflateAfterStreamEnd);
+  CPPUNIT_TEST(testInflateBroken);
+  CPPUNIT_TEST(testDeflateInPieces);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void testInflateInPieces()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    const ByteVector data = testData();
+    const ByteVector compressed = zlib::compress(data);
+    CPPUNIT_ASSERT(compressed.size() < data.size());
+    CPPUNIT_ASSERT_EQUAL(data, zlib::decompress(compressed));
+
+    // The output grows from its initial size as the pieces come in.
+
+    const unsigned int sizeHints[] = { 0, 10, data.size(), data.size() * 2 };
+    for(unsigned int i = 0; i < sizeof(sizeHints) / sizeof(sizeHints[0]); ++i) {
+      zlib::Inflater inflater(sizeHints[i]);
+
+      unsigned int outputSize = 0;
+      for(unsigned int pos = 0; pos < compressed.size(); pos += 97) {
+        CPPUNIT_ASSERT(!inflater.isFinished());
+        CPPUNIT_ASSERT(inflater.write(compressed.mid(pos, 97)));
+
+        const unsigned int size = inflater.output().size();
+        CPPUNIT_ASSERT(size >= outputSize);
+        outputSize = size;
+      }
+
+      CPPUNIT_ASSERT(inflater.isFinished());
+      CPPUNIT_ASSERT_EQUAL(data, inflater.output());
+    }
+  }
+
+  void testInflateAfterStreamEnd()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    const ByteVector data = testData();
+    const ByteVector compressed = zlib::compress(data);
+
+    // Data after the end of the stream, in the same piece or in later ones,
+    // is ignored.
+
+    zlib::Inflater inflater;
+    const unsigned int half = compressed.size() / 2;
+    CPPUNIT_ASSERT(inflater.write(compressed.mid(0, half)));
+    CPPUNIT_ASSERT(inflater.write(compressed.mid(half) + ByteVector("junk")));
+    CPPUNIT_ASSERT(inflater.isFinished());
+    CPPUNIT_ASSERT(inflater.write(ByteVector("more junk")));
+    CPPUNIT_ASSERT(inflater.isFinished());
+    CPPUNIT_ASSERT_EQUAL(data, inflater.output());
+  }
+
+  void testInflateBroken()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    const ByteVector compressed = zlib::compress(testData());
+
+    // The header is split, and its check bits are wrong.  Nothing is accepted
+    // after the error.
+
+    zlib::Inflater inflater;
+    CPPUNIT_ASSERT(inflater.write(ByteVector(1, '\x78')));
+    CPPUNIT_ASSERT(!inflater.write(ByteVector(1, '\0') + compressed.mid(2)));
+    CPPUNIT_ASSERT(!inflater.write(compressed));
+    CPPUNIT_ASSERT(!inflater.isFinished());
+
+    CPPUNIT_ASSERT(zlib::decompress(ByteVector("not compressed")).isEmpty());
+  }
+
+  void testDeflateInPieces()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    const ByteVector data = testData();
+
+    // Without flushing, the compressed stream does not depend on how the
+    // data is split.
+
+    zlib::Deflater deflater;
+    for(unsigned int pos = 0; pos < data.size(); pos += 1001)
+      CPPUNIT_ASSERT(deflater.write(data.mid(pos, 1001)));
+    CPPUNIT_ASSERT(deflater.write(ByteVector()));
+
+    const ByteVector compressed = deflater.finish();
+    CPPUNIT_ASSERT_EQUAL(zlib::compress(data), compressed);
+    CPPUNIT_ASSERT_EQUAL(data, zlib::decompress(compressed, data.size()));
+
+    // The stream can not be continued once it is finished.
+
+    CPPUNIT_ASSERT(!deflater.write(data));
+    CPPUNIT_ASSERT_EQUAL(compressed, deflater.finish());
+
+    zlib::Deflater empty;
+    CPPUNIT_ASSERT(zlib::decompress(empty.finish()).isEmpty());
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestZLib);